@@ -0,0 +1,151 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_BATCHED_ENVIRONMENT_H
+#define PAL_HARDWARE_GAZEBO_BATCHED_ENVIRONMENT_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <ros/ros.h>
+#include <gazebo/common/Events.hh>
+
+#include <gazebo/physics/physics.hh>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Steps all the robots of a world as one vectorized environment.
+ *
+ * Each plugin instance with batched_step/enabled owns a slot, with its
+ * observations and actions stored one robot after the other in two
+ * contiguous buffers. The robots take their commands from the action buffer
+ * before writing and gather their observations after reading. The joints of
+ * the batched_step/actions channels are written whether or not a controller
+ * runs, and controllers claiming them are rejected. step()
+ * returns once the world has advanced, after every robot has read its state
+ * again at the end of the last physics iteration, so the observations are
+ * those resulting from the actions. That last read bypasses the hardware
+ * emulation.
+ *
+ * To be used from code running in the Gazebo process, outside of the world
+ * update thread, with the world paused:
+ *
+ *   boost::shared_ptr<BatchedEnvironment> env = BatchedEnvironment::forWorld(world);
+ *   std::copy(actions, actions + env->actionSize(), env->actions());
+ *   env->step();
+ *   consume(env->observations(), env->observationSize());
+ */
+class BatchedEnvironment
+{
+public:
+  static boost::shared_ptr<BatchedEnvironment> forWorld(gazebo::physics::WorldPtr world);
+
+  /// Reads the state of a robot and gathers its observations, at the given time
+  typedef boost::function<void(const ros::Time&)> ReadCallback;
+
+  explicit BatchedEnvironment(gazebo::physics::WorldPtr world);
+
+  /// Adds a robot, returns its slot
+  size_t addRobot(const std::string& name, size_t observation_size, size_t action_size,
+                  const ReadCallback& read);
+  /// Frees the slot; the other slots keep their offsets
+  void removeRobot(size_t slot);
+
+  /// Observations of a robot, to be written by the robot
+  double* robotObservation(size_t slot)
+  {
+    return &observations_[robots_[slot].observationOffset];
+  }
+  /// Actions of a robot, to be read by the robot
+  double* robotAction(size_t slot)
+  {
+    return &actions_[robots_[slot].actionOffset];
+  }
+
+  /// Control period of the robots, reported by them when reading
+  void setControlPeriod(const ros::Duration& period)
+  {
+    controlPeriod_ = period.toSec();
+  }
+
+  /// Advances the world by the given number of control periods, each robot
+  /// reading and writing once per period. Blocks until done.
+  void step(unsigned int control_periods = 1);
+
+  /// Physics iterations per control period, 1 until a robot has read once
+  unsigned int iterationsPerPeriod() const;
+
+  size_t robots() const
+  {
+    return robots_.size();
+  }
+  const std::string& robotName(size_t slot) const
+  {
+    return robots_[slot].name;
+  }
+  size_t observationOffset(size_t slot) const
+  {
+    return robots_[slot].observationOffset;
+  }
+  size_t actionOffset(size_t slot) const
+  {
+    return robots_[slot].actionOffset;
+  }
+
+  /// Stacked observations of all the robots
+  const double* observations() const
+  {
+    return observations_.data();
+  }
+  size_t observationSize() const
+  {
+    return observations_.size();
+  }
+  /// Stacked actions of all the robots, set before stepping
+  double* actions()
+  {
+    return actions_.data();
+  }
+  size_t actionSize() const
+  {
+    return actions_.size();
+  }
+
+private:
+  struct Robot
+  {
+    std::string name;
+    size_t observationOffset;
+    size_t actionOffset;
+    ReadCallback read;
+  };
+
+  /// Called by the world update thread after every physics iteration
+  void onWorldUpdateEnd();
+
+  gazebo::physics::WorldPtr world_;
+  gazebo::event::ConnectionPtr worldUpdateEnd_;
+  std::atomic<double> controlPeriod_;
+  /// Physics iterations left in the current step
+  unsigned int remainingIterations_;
+  boost::mutex mutex_;
+  boost::condition_variable stepDone_;
+  std::vector<Robot> robots_;
+  std::vector<double> observations_;
+  std::vector<double> actions_;
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_BATCHED_ENVIRONMENT_H
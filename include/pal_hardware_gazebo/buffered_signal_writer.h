@@ -0,0 +1,90 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_BUFFERED_SIGNAL_WRITER_H
+#define PAL_HARDWARE_GAZEBO_BUFFERED_SIGNAL_WRITER_H
+
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <boost/thread/thread.hpp>
+
+#include <ros/ros.h>
+
+#include <pal_hardware_gazebo/spsc_ring.h>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Reads the header shared by the signal file formats: the 8 byte
+ * magic, a uint32 signal count, then per signal a uint16 name length
+ * followed by the name. Returns false if the magic does not match.
+ */
+bool readSignalNames(std::istream& in, const char* magic, std::vector<std::string>& names);
+
+/**
+ * @brief Base for writers storing a set of signals to a local file from a
+ * background thread.
+ *
+ * The simulation thread copies one row per recorded tick into a lock-free
+ * ring, the first value of the row being the simulation time in seconds.
+ * The background thread hands the rows to the concrete file format.
+ * Subclasses must call stop() from their destructor.
+ */
+class BufferedSignalWriter
+{
+public:
+  BufferedSignalWriter();
+  virtual ~BufferedSignalWriter();
+
+  /// Adds a signal to write, only before start()
+  void addSignal(const std::string& name, const double* value);
+
+  bool start(const std::string& file_name, size_t buffer_rows, unsigned int decimation);
+  void stop();
+
+  /// Copies the current value of all the signals, real-time safe
+  void record(const ros::Time& time);
+
+  /// Records factor times less often than configured, 1 to restore
+  void setDecimationFactor(unsigned int factor)
+  {
+    decimationFactor_ = factor;
+  }
+
+protected:
+  /// Called from start(), once the file is open
+  virtual bool writeHeader() = 0;
+  /// Called from the background thread for every recorded row
+  virtual void writeRow(const double* row) = 0;
+  /// Called from the background thread after the last row
+  virtual void finish() = 0;
+
+  /// Signal names, "time" first
+  std::vector<std::string> names_;
+  std::ofstream file_;
+
+private:
+  void writerLoop();
+
+  std::vector<const double*> values_;
+  unsigned int decimation_;
+  unsigned int decimationFactor_;
+  unsigned int tick_;
+
+  SpscRing<double> ring_;
+  std::atomic<unsigned long> droppedRows_;
+
+  std::atomic<bool> running_;
+  boost::thread writerThread_;
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_BUFFERED_SIGNAL_WRITER_H
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_CENTER_OF_MASS_INTERFACE_H
+#define PAL_HARDWARE_GAZEBO_CENTER_OF_MASS_INTERFACE_H
+
+#include <string>
+
+#include <hardware_interface/internal/hardware_resource_manager.h>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Whole-body center of mass and momentum of the robot, expressed in
+ * the world frame. The angular momentum is taken about the center of mass.
+ */
+class CenterOfMassHandle
+{
+public:
+  struct Data
+  {
+    Data()
+      : mass(NULL)
+      , position(NULL)
+      , velocity(NULL)
+      , linear_momentum(NULL)
+      , angular_momentum(NULL)
+    {
+    }
+
+    std::string name;
+    std::string frame_id;
+    const double* mass;
+    const double* position;
+    const double* velocity;
+    const double* linear_momentum;
+    const double* angular_momentum;
+  };
+
+  CenterOfMassHandle(const Data& data = Data()) : data_(data)
+  {
+  }
+
+  std::string getName() const
+  {
+    return data_.name;
+  }
+  std::string getFrameId() const
+  {
+    return data_.frame_id;
+  }
+  double getMass() const
+  {
+    return *data_.mass;
+  }
+  const double* getPosition() const
+  {
+    return data_.position;
+  }
+  const double* getVelocity() const
+  {
+    return data_.velocity;
+  }
+  const double* getLinearMomentum() const
+  {
+    return data_.linear_momentum;
+  }
+  const double* getAngularMomentum() const
+  {
+    return data_.angular_momentum;
+  }
+
+private:
+  Data data_;
+};
+
+class CenterOfMassInterface : public hardware_interface::HardwareResourceManager<CenterOfMassHandle>
+{
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_CENTER_OF_MASS_INTERFACE_H
@@ -0,0 +1,57 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_CENTER_OF_MASS_STATE_H
+#define PAL_HARDWARE_GAZEBO_CENTER_OF_MASS_STATE_H
+
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <gazebo/physics/physics.hh>
+
+#include <pal_hardware_gazebo/center_of_mass_interface.h>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Aggregates the center of mass and momentum of all the links of the
+ * model, straight from the physics engine state.
+ */
+class CenterOfMassState
+{
+public:
+  CenterOfMassState();
+
+  bool init(gazebo::physics::ModelPtr model);
+
+  /// Reads all link states and recomputes the aggregates
+  void update();
+
+  CenterOfMassHandle::Data getHandleData(const std::string& name) const;
+
+private:
+  std::vector<gazebo::physics::LinkPtr> links_;
+  Eigen::VectorXd masses_;
+  double totalMass_;
+
+  // Per-link CoG position, CoG velocity and angular velocity, one per column
+  Eigen::Matrix3Xd positions_;
+  Eigen::Matrix3Xd velocities_;
+  Eigen::Matrix3Xd angularVelocities_;
+  std::vector<Eigen::Matrix3d> worldInertias_;
+
+  double mass_;
+  double position_[3];
+  double velocity_[3];
+  double linearMomentum_[3];
+  double angularMomentum_[3];
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_CENTER_OF_MASS_STATE_H
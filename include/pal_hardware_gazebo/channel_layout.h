@@ -0,0 +1,60 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_CHANNEL_LAYOUT_H
+#define PAL_HARDWARE_GAZEBO_CHANNEL_LAYOUT_H
+
+#include <string>
+#include <vector>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Fixed selection of channels, packed into or unpacked from a
+ * contiguous vector in the order they were selected.
+ */
+class ChannelLayout
+{
+public:
+  /// Selects the wanted channels among the available ones, by name
+  bool init(const std::vector<std::string>& wanted, const std::vector<std::string>& names,
+            const std::vector<double*>& channels);
+
+  size_t size() const
+  {
+    return channels_.size();
+  }
+  const std::vector<std::string>& names() const
+  {
+    return names_;
+  }
+
+  /// Copies the channels into out, which holds size() values
+  void gather(double* out) const
+  {
+    for (size_t i = 0; i < channels_.size(); ++i)
+    {
+      out[i] = *channels_[i];
+    }
+  }
+  /// Copies in, which holds size() values, into the channels
+  void scatter(const double* in) const
+  {
+    for (size_t i = 0; i < channels_.size(); ++i)
+    {
+      *channels_[i] = in[i];
+    }
+  }
+
+private:
+  std::vector<std::string> names_;
+  std::vector<double*> channels_;
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_CHANNEL_LAYOUT_H
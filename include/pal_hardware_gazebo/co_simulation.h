@@ -0,0 +1,138 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_CO_SIMULATION_H
+#define PAL_HARDWARE_GAZEBO_CO_SIMULATION_H
+
+#include <string>
+#include <vector>
+
+#include <ros/ros.h>
+
+#include <pal_hardware_gazebo/channel_layout.h>
+#include <pal_hardware_gazebo/shared_memory.h>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Layout of the start of the co-simulation block.
+ *
+ * The header is followed by output_size doubles written by the simulation,
+ * input_size doubles written by the partner, and the names of the output
+ * and then input channels, each one terminated by a null character.
+ *
+ * tick is a sequence lock on the outputs, time, period and notify_time_ns:
+ * the simulation makes it odd while it writes them, with its
+ * CLOCK_MONOTONIC time in notify_time_ns, then even again once done. The
+ * partner spins on a new even tick, reads the outputs, and reads again if
+ * tick changed meanwhile, since a partner that missed its deadline may
+ * still be reading when the next tick starts writing. It then steps, writes
+ * the inputs and ack_time_ns, and stores the tick it read into ack.
+ *
+ * missed counts the ticks the simulation gave up waiting for, the partner
+ * compares it to tell that its late inputs were dropped.
+ */
+struct CoSimulationHeader
+{
+  static const uint32_t MAGIC = 0x50414c53;  // "PALS"
+  static const uint32_t VERSION = 3;
+
+  uint32_t magic;
+  uint32_t version;
+  uint32_t output_size;
+  uint32_t input_size;
+  uint32_t names_offset;
+  uint32_t names_size;
+  FutexWord tick;
+  FutexWord ack;
+  FutexWord missed;
+  uint64_t notify_time_ns;
+  uint64_t ack_time_ns;
+  double time;
+  double period;
+};
+
+/**
+ * @brief Steps a partner process in lockstep with the simulation.
+ *
+ * The partner is notified when reading, so it runs while the controllers
+ * update, and the simulation waits for its answer before writing. The
+ * handshake spins on shared memory, only yielding the core now and then
+ * while waiting.
+ *
+ * Parameters, under the "co_simulation" namespace:
+ *  - enabled: defaults to false
+ *  - name: shared memory name, defaults to /<robot namespace>_co_simulation
+ *  - outputs: channels sent to the partner, joint state, sensor or command
+ *    channels like "arm_1_joint/position" or "arm_1_joint/effort_command".
+ *    The commands sent are those of the previous tick.
+ *  - inputs: command channels overwritten by the partner
+ *  - timeout: seconds to wait for the partner (default 0.01)
+ *  - on_timeout: "proceed" (default) writes without the inputs of the tick,
+ *    "hold" keeps waiting, stalling the simulation until the partner answers.
+ *    The timeout is counted as missed either way.
+ */
+class CoSimulation
+{
+public:
+  CoSimulation();
+
+  /// Outputs can be any of the given channels, inputs only the writable ones
+  bool init(ros::NodeHandle& nh, const std::string& default_name,
+            const std::vector<std::string>& channel_names, const std::vector<double*>& channels,
+            const std::vector<std::string>& writable_names, const std::vector<double*>& writable);
+
+  bool enabled() const
+  {
+    return enabled_;
+  }
+
+  /// Sends the outputs and notifies the partner, call after reading
+  void notify(const ros::Time& time, const ros::Duration& period);
+  /// Waits for the partner and applies its inputs, call before writing.
+  /// Returns false if the inputs were not applied.
+  bool acknowledge();
+
+  /// Last and largest notification to acknowledgement time, in seconds
+  double lastRoundTrip() const
+  {
+    return lastRoundTrip_;
+  }
+  double maxRoundTrip() const
+  {
+    return maxRoundTrip_;
+  }
+  unsigned long timeouts() const
+  {
+    return timeouts_;
+  }
+
+private:
+  /// Spins until the partner answers or the CLOCK_MONOTONIC deadline passes
+  bool waitForPartner(uint64_t deadline);
+
+  bool enabled_;
+  double timeout_;
+  bool holdOnTimeout_;
+  SharedMemorySegment segment_;
+  CoSimulationHeader* header_;
+  double* outputs_;
+  double* inputs_;
+
+  ChannelLayout outputLayout_;
+  ChannelLayout inputLayout_;
+  uint32_t tick_;
+  bool pending_;
+
+  double lastRoundTrip_;
+  double maxRoundTrip_;
+  unsigned long timeouts_;
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_CO_SIMULATION_H
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_COLUMNAR_EXPORTER_H
+#define PAL_HARDWARE_GAZEBO_COLUMNAR_EXPORTER_H
+
+#include <pal_hardware_gazebo/buffered_signal_writer.h>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Writes a set of signals to a local columnar binary file.
+ *
+ * File layout, little endian:
+ *  - header: "PALCOL01", uint32 column count, then per column a uint16 name
+ *    length followed by the name. All columns are float64, the first one is
+ *    the simulation time in seconds.
+ *  - chunks: uint32 row count, then for every column its values for all the
+ *    rows of the chunk, contiguous.
+ *
+ * Parameters, under the "introspection_export" namespace:
+ *  - file: output path, the export is disabled if empty
+ *  - chunk_rows: rows per chunk (default 1000)
+ *  - buffer_rows: capacity of the ring (default 10000)
+ *  - decimation: record one out of this many ticks (default 1)
+ */
+class ColumnarExporter : public BufferedSignalWriter
+{
+public:
+  ColumnarExporter();
+  ~ColumnarExporter();
+
+  /// Reads the configuration, returns false on errors only
+  bool configure(ros::NodeHandle& nh);
+  /// Configures without parameters, an empty file name disables the export
+  bool configure(const std::string& file_name, size_t chunk_rows, size_t buffer_rows,
+                 unsigned int decimation);
+
+  bool enabled() const
+  {
+    return enabled_;
+  }
+
+  bool start();
+
+protected:
+  bool writeHeader();
+  void writeRow(const double* row);
+  void finish();
+
+private:
+  void flushChunk();
+
+  bool enabled_;
+  std::string fileName_;
+  size_t chunkRows_;
+  size_t bufferRows_;
+  unsigned int decimation_;
+
+  std::vector<double> chunk_;
+  size_t chunkFill_;
+};
+
+/**
+ * @brief Reads back a file written by the ColumnarExporter, one chunk at a
+ * time.
+ */
+class ColumnarReader
+{
+public:
+  bool open(const std::string& file_name);
+
+  /// Column names, "time" first
+  const std::vector<std::string>& names() const
+  {
+    return names_;
+  }
+
+  /// Appends the rows of the next chunk to rows, row-major. Returns false at
+  /// the end of the file or on a truncated chunk, leaving rows unchanged.
+  bool readChunk(std::vector<double>& rows);
+
+private:
+  std::ifstream file_;
+  std::vector<std::string> names_;
+  std::vector<double> chunk_;
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_COLUMNAR_EXPORTER_H
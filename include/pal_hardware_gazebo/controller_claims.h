@@ -0,0 +1,116 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_CONTROLLER_CLAIMS_H
+#define PAL_HARDWARE_GAZEBO_CONTROLLER_CLAIMS_H
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <hardware_interface/controller_info.h>
+
+#include <pal_hardware_gazebo/joint_buffers.h>
+#include <pal_hardware_gazebo/name_index.h>
+#include <pal_hardware_gazebo/resource_bitset.h>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Resources claimed by the controllers, as bitsets over the joint
+ * indices of the joint buffers.
+ *
+ * The bitsets of a controller are computed when a switch starting it is
+ * prepared, and cached by controller name while it runs, so that switches
+ * only do word-wide operations on running controllers. The entry is dropped
+ * when the controller stops, a controller reloaded under the same name
+ * having to stop first. Claimed resources that are not joints
+ * are rare and kept as plain names. Joint groups can be registered so that
+ * claiming a group name claims all of its joints. Joints written by the
+ * plugin itself are reserved, they conflict with every controller.
+ */
+class ControllerClaims
+{
+public:
+  typedef std::list<hardware_interface::ControllerInfo> ControllerList;
+
+  ControllerClaims();
+
+  void init(const JointBuffers& joints);
+
+  /// Registers a joint group, returns its index, only before any switch
+  size_t addGroup(const std::string& name, const std::vector<size_t>& joint_indices);
+
+  /// Reserves the joints claimed by owner, which is not a running controller
+  void reserve(const hardware_interface::ControllerInfo& owner);
+
+  /// Joints written by the plugin itself
+  const ResourceBitset& reserved() const
+  {
+    return reserved_;
+  }
+
+  /// Returns true and the name of a resource claimed twice, if any
+  bool findConflict(const ControllerList& controllers, std::string& resource) const;
+
+  /// Returns true and the name of a resource the started controllers would
+  /// share with a running one, if any
+  bool findSwitchConflict(const ControllerList& start_list, const ControllerList& stop_list,
+                          std::string& resource) const;
+
+  void doSwitch(const ControllerList& start_list, const ControllerList& stop_list);
+
+  /// Joints claimed by the running controllers
+  const ResourceBitset& active() const
+  {
+    return active_;
+  }
+
+  const NameIndex& groupIndex() const
+  {
+    return groupIndex_;
+  }
+
+  /// Groups claimed by the running controllers
+  const ResourceBitset& activeGroups() const
+  {
+    return activeGroups_;
+  }
+
+private:
+  struct Claims
+  {
+    ResourceBitset joints;
+    ResourceBitset groups;
+    std::vector<std::string> others;
+  };
+
+  /// Claims of a running or pending controller, NULL if not cached
+  const Claims* cached(const std::string& name) const;
+  void build(const hardware_interface::ControllerInfo& info, Claims& claims) const;
+  bool accumulate(const Claims& claims, ResourceBitset& joints,
+                  std::vector<std::string>& others, std::string& resource) const;
+
+  const JointBuffers* joints_;
+  /// Claims of the running controllers
+  std::map<std::string, Claims> cache_;
+  /// Claims of the controllers started by the prepared switch
+  mutable std::map<std::string, Claims> pending_;
+  std::vector<std::string> groupNames_;
+  NameIndex groupIndex_;
+  std::vector<ResourceBitset> groupJoints_;
+
+  ResourceBitset reserved_;
+  ResourceBitset active_;
+  ResourceBitset activeGroups_;
+  std::vector<std::string> activeOthers_;
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_CONTROLLER_CLAIMS_H
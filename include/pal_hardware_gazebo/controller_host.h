@@ -0,0 +1,106 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_CONTROLLER_HOST_H
+#define PAL_HARDWARE_GAZEBO_CONTROLLER_HOST_H
+
+#include <string>
+#include <vector>
+
+#include <ros/ros.h>
+
+#include <pal_hardware_gazebo/shared_memory.h>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Layout of the start of the controller host mailbox.
+ *
+ * The header is followed by state_size doubles of state, command_size
+ * doubles of commands, and the names of the state and then command
+ * channels, each one terminated by a null character.
+ *
+ * state_seq is a sequence lock on the state, time and period: the
+ * simulation makes it odd while it writes them, then even again once done
+ * and wakes it. The controller process waits for a new even state_seq,
+ * reads the state, and reads again if state_seq changed meanwhile, since a
+ * late controller may still be reading when the next tick starts writing.
+ * It then writes the commands, stores the state_seq it read into
+ * command_seq and wakes it.
+ */
+struct ControllerMailboxHeader
+{
+  static const uint32_t MAGIC = 0x50414c43;  // "PALC"
+  static const uint32_t VERSION = 2;
+
+  uint32_t magic;
+  uint32_t version;
+  uint32_t state_size;
+  uint32_t command_size;
+  uint32_t names_offset;
+  uint32_t names_size;
+  FutexWord state_seq;
+  FutexWord command_seq;
+  double time;
+  double period;
+};
+
+/**
+ * @brief Exchanges the hardware state and commands with a controller
+ * running in another process, through a shared memory mailbox.
+ *
+ * Parameters, under the "controller_host" namespace:
+ *  - enabled: defaults to false
+ *  - name: shared memory name, defaults to /<robot namespace>_controller_host
+ *  - timeout: seconds to wait for the commands of a tick (default 0.01).
+ *    On timeout the previous commands are held.
+ *  - commands: command channels driven by the controller process, like
+ *    "arm_1_joint/effort_command", defaults to the first interface of every
+ *    joint. Their joints are written through the channel interface, and
+ *    controllers claiming them are rejected.
+ */
+class ControllerHost
+{
+public:
+  ControllerHost();
+
+  bool init(ros::NodeHandle& nh, const std::string& default_name,
+            const std::vector<double*>& state, const std::vector<std::string>& state_names,
+            const std::vector<double*>& commands, const std::vector<std::string>& command_names);
+
+  bool enabled() const
+  {
+    return enabled_;
+  }
+
+  /// Copies the state to the mailbox and signals it, call after reading
+  void publishState(const ros::Time& time, const ros::Duration& period);
+  /// Waits for the commands answering the last state, call before writing
+  bool receiveCommands();
+
+  unsigned long timeouts() const
+  {
+    return timeouts_;
+  }
+
+private:
+  bool enabled_;
+  double timeout_;
+  SharedMemorySegment segment_;
+  ControllerMailboxHeader* header_;
+  double* state_;
+  double* commands_;
+
+  std::vector<double*> stateSources_;
+  std::vector<double*> commandTargets_;
+  uint32_t seq_;
+  unsigned long timeouts_;
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_CONTROLLER_HOST_H
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_DIFF_DRIVE_GEOMETRY_H
+#define PAL_HARDWARE_GAZEBO_DIFF_DRIVE_GEOMETRY_H
+
+#include <string>
+#include <vector>
+
+#include <ros/ros.h>
+
+#include <pal_hardware_gazebo/joint_buffers.h>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Wheel layout of a differential drive base.
+ *
+ * Parameters, under the "mobile_base" namespace:
+ *  - left_wheels, right_wheels: wheel joint names
+ *  - wheel_radius, wheel_separation
+ */
+class DiffDriveGeometry
+{
+public:
+  DiffDriveGeometry();
+
+  /// Returns false if the base is not configured or the configuration is wrong
+  bool init(ros::NodeHandle& nh, const JointBuffers& joints);
+
+  /// Planar twist of the base for the given mean wheel velocities
+  void twist(double left_velocity, double right_velocity, double& linear, double& angular) const
+  {
+    linear = wheelRadius * (left_velocity + right_velocity) * 0.5;
+    angular = wheelRadius * (right_velocity - left_velocity) / wheelSeparation;
+  }
+
+  /// Mean of the given values over the wheels of a side
+  static double mean(const std::vector<size_t>& wheels, const std::vector<double*>& values);
+
+  std::vector<size_t> leftWheels;
+  std::vector<size_t> rightWheels;
+  double wheelRadius;
+  double wheelSeparation;
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_DIFF_DRIVE_GEOMETRY_H
@@ -0,0 +1,50 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_FLOATING_BASE_STATE_H
+#define PAL_HARDWARE_GAZEBO_FLOATING_BASE_STATE_H
+
+#include <string>
+#include <vector>
+
+#include <gazebo/physics/physics.hh>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief World pose and twist of the model, as channels named
+ * base/{position_x, ..., orientation_x, ..., orientation_w,
+ * linear_velocity_x, ..., angular_velocity_z}.
+ *
+ * The plugin does not read them otherwise, so they are only updated when a
+ * consumer selects one of them.
+ */
+class FloatingBaseState
+{
+public:
+  FloatingBaseState();
+
+  void init(gazebo::physics::ModelPtr model);
+
+  /// Appends the base channels to the given ones
+  void addChannels(std::vector<std::string>& names, std::vector<double*>& channels);
+
+  /// Whether any of the given channel names is a base channel
+  static bool uses(const std::vector<std::string>& names);
+
+  void update();
+
+private:
+  static const size_t SIZE = 13;
+
+  gazebo::physics::ModelPtr model_;
+  double state_[SIZE];
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_FLOATING_BASE_STATE_H
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_GRASP_MANAGER_H
+#define PAL_HARDWARE_GAZEBO_GRASP_MANAGER_H
+
+#include <string>
+#include <vector>
+
+#include <ros/ros.h>
+#include <gazebo/physics/physics.hh>
+
+#include <pal_hardware_gazebo/joint_buffers.h>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Attaches grasped objects to the gripper instead of holding them
+ * through friction contacts.
+ *
+ * A grasp is detected when enough fingers touch the same link of another
+ * model, which is not static, and the finger joints have stalled for a
+ * number of ticks. The object is then attached to the palm link with a joint
+ * locked at its current pose. It is released as soon as a finger joint moves
+ * in the opening direction away from the position it had when grasping;
+ * squeezing further keeps it attached.
+ *
+ * Parameters, under "grasping/<gripper>":
+ *  - palm_link: link the object is attached to
+ *  - finger_links, finger_joints: link and joint names of the fingers
+ *  - min_fingers: fingers in contact needed for a grasp (default 2)
+ *  - stall_velocity: finger joint speed below which it is stalled (default 0.01)
+ *  - stable_ticks: ticks the grasp has to hold before attaching (default 10)
+ *  - release_tolerance: finger joint motion that releases the object (default 0.005)
+ *  - open_direction: sign of the finger joint motion that opens the gripper,
+ *    1 or -1 (default 1)
+ */
+class GraspManager
+{
+public:
+  bool init(ros::NodeHandle& nh, const std::vector<std::string>& gripper_names,
+            const JointBuffers& joints, gazebo::physics::ModelPtr model);
+
+  bool enabled() const
+  {
+    return !grippers_.empty();
+  }
+
+  /// Indices of the finger joints, whose states are needed on every tick
+  std::vector<size_t> fingerJoints() const;
+
+  /// Detects grasps and releases from the last contacts, call after reading
+  void update();
+
+private:
+  struct Gripper
+  {
+    std::string name;
+    gazebo::physics::LinkPtr palm;
+    std::vector<gazebo::physics::LinkPtr> fingerLinks;
+    std::vector<size_t> fingerJoints;
+    int minFingers;
+    double stallVelocity;
+    int stableTicks;
+    double releaseTolerance;
+    double openDirection;
+
+    /// Object touched by each finger in the current tick
+    std::vector<gazebo::physics::LinkPtr> touched;
+    gazebo::physics::LinkPtr candidate;
+    int heldTicks;
+    gazebo::physics::JointPtr attachment;
+    std::vector<double> graspPositions;
+  };
+
+  void collectContacts();
+  gazebo::physics::LinkPtr graspedObject(const Gripper& gripper) const;
+  bool stalled(const Gripper& gripper) const;
+  bool opened(const Gripper& gripper) const;
+  void attach(Gripper& gripper, const gazebo::physics::LinkPtr& object);
+  void detach(Gripper& gripper);
+
+  gazebo::physics::ModelPtr model_;
+  const JointBuffers* joints_;
+  gazebo::physics::ContactManager* contactManager_;
+  std::vector<Gripper> grippers_;
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_GRASP_MANAGER_H
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_HARDWARE_EMULATION_H
+#define PAL_HARDWARE_GAZEBO_HARDWARE_EMULATION_H
+
+#include <vector>
+
+#include <ros/ros.h>
+
+#include <pal_hardware_gazebo/joint_buffers.h>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Fixed delay of a vector of samples, implemented as a ring buffer
+ * preallocated at init.
+ */
+class DelayLine
+{
+public:
+  DelayLine();
+
+  void init(size_t width, unsigned int delay);
+
+  /**
+   * @brief Stores a new sample and returns the one pushed @p delay ticks ago.
+   * Until the line fills up, the first sample ever pushed is returned.
+   */
+  const double* push(const double* sample);
+
+  unsigned int delay() const
+  {
+    return delay_;
+  }
+
+private:
+  std::vector<double> buffer_;
+  size_t width_;
+  unsigned int delay_;
+  size_t head_;
+  bool primed_;
+};
+
+/**
+ * @brief Emulation of real hardware artifacts: encoder quantization and bus
+ * transport delays on sensor data and actuator commands.
+ *
+ * Parameters, under the "hardware_emulation" namespace:
+ *  - sensor_delay_ticks: delay applied to all joint states, FT and IMU readings
+ *  - actuator_delay_ticks: delay applied to the joint commands of every interface
+ *  - encoder_resolution/<joint>: position quantization step of the joint
+ */
+class HardwareEmulation
+{
+public:
+  HardwareEmulation();
+
+  bool init(ros::NodeHandle& nh, const JointBuffers& joints,
+            const std::vector<double*>& sensor_channels);
+
+  bool enabled() const
+  {
+    return enabled_;
+  }
+
+  /// Whether the sensor channels go through a delay line
+  bool delaysSensors() const
+  {
+    return !sensorChannels_.empty();
+  }
+
+  /// Quantizes and delays the sensor channels in place, call after reading
+  void processSensors();
+
+  /// Replaces the commands by their delayed values, call before writing
+  void delayCommands();
+
+  /// Restores the commands set by the controllers, call after writing
+  void restoreCommands();
+
+private:
+  bool enabled_;
+
+  std::vector<double*> quantizedPositions_;
+  std::vector<double> resolutions_;
+
+  std::vector<double*> sensorChannels_;
+  std::vector<double> sensorSample_;
+  DelayLine sensorDelay_;
+
+  std::vector<double*> commandChannels_;
+  std::vector<double> commandSample_;
+  DelayLine actuatorDelay_;
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_HARDWARE_EMULATION_H
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_HARDWARE_SCHEDULER_H
+#define PAL_HARDWARE_GAZEBO_HARDWARE_SCHEDULER_H
+
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <ros/ros.h>
+
+#include <pal_hardware_gazebo/worker_pool.h>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Hardware that can have its read and write phases run by a
+ * HardwareScheduler, from any thread.
+ */
+class ScheduledHardware
+{
+public:
+  virtual ~ScheduledHardware()
+  {
+  }
+
+  virtual void readHardware(const ros::Time& time, const ros::Duration& period) = 0;
+  virtual void writeHardware(const ros::Time& time, const ros::Duration& period) = 0;
+
+  /// Steps touching process or world wide state, run after the phase of the same name,
+  /// one robot after the other on the world update thread
+  virtual void readSerial(const ros::Time& time, const ros::Duration& period)
+  {
+  }
+  virtual void writeSerial(const ros::Time& time, const ros::Duration& period)
+  {
+  }
+};
+
+/**
+ * @brief Runs the hardware phases of all the robots of a world in parallel.
+ *
+ * Gazebo calls readSim, the controller update and writeSim of each robot in
+ * turn. The first read of a tick reads all the robots at once; the other
+ * reads of that tick find their state ready. Writes are held back until the
+ * last robot of the tick has written, then all of them are written at once,
+ * before the physics step. The serial steps of every robot follow each
+ * parallel phase on the calling thread. The controller updates still run one
+ * after the other, they are driven by the controller managers.
+ *
+ * All the scheduled robots must share the same control period. If a tick
+ * starts with writes still held back, they are flushed first.
+ */
+class HardwareScheduler
+{
+public:
+  /// Scheduler of the given world, created on first use with that many threads
+  static boost::shared_ptr<HardwareScheduler> forWorld(const std::string& world_name,
+                                                       size_t threads);
+
+  explicit HardwareScheduler(size_t threads);
+
+  void add(ScheduledHardware* hardware);
+  void remove(ScheduledHardware* hardware);
+
+  void read(ScheduledHardware* hardware, const ros::Time& time, const ros::Duration& period);
+  void write(ScheduledHardware* hardware, const ros::Time& time, const ros::Duration& period);
+
+private:
+  struct Entry
+  {
+    ScheduledHardware* hardware;
+    bool writePending;
+    ros::Time writeTime;
+    ros::Duration writePeriod;
+  };
+
+  void readEntry(size_t i);
+  void writeEntry(size_t i);
+  void flushWrites();
+
+  boost::mutex mutex_;
+  WorkerPool pool_;
+  std::vector<Entry> entries_;
+  bool readDone_;
+  ros::Time readTime_;
+  ros::Duration readPeriod_;
+  size_t pendingWrites_;
+  WorkerPool::Task readTask_;
+  WorkerPool::Task writeTask_;
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_HARDWARE_SCHEDULER_H
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_JOINT_BUFFERS_H
+#define PAL_HARDWARE_GAZEBO_JOINT_BUFFERS_H
+
+#include <string>
+#include <vector>
+
+#include <hardware_interface/robot_hw.h>
+#include <gazebo/physics/physics.hh>
+
+#include <pal_hardware_gazebo/name_index.h>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Flat view of the joint state and command buffers owned by the
+ * simulation resources.
+ *
+ * Gathered once from the registered joint handles after the resources have
+ * been created, so that the plugin can post-process the data in place without
+ * going through the handle maps every tick.
+ */
+class JointBuffers
+{
+public:
+  enum CommandType
+  {
+    NO_COMMAND,
+    POSITION_COMMAND,
+    VELOCITY_COMMAND,
+    EFFORT_COMMAND
+  };
+
+  /// Without a model, as in the tests, simJoints are all NULL
+  bool init(hardware_interface::RobotHW* robot_hw, gazebo::physics::ModelPtr model);
+
+  size_t size() const
+  {
+    return names.size();
+  }
+
+  /// Index of the joint in the buffers, -1 if unknown
+  int index(const std::string& name) const
+  {
+    return nameIndex_.find(name);
+  }
+
+  const NameIndex& nameIndex() const
+  {
+    return nameIndex_;
+  }
+
+  /// Command of the joint through the given interface, NULL if it does not expose it
+  double* commandFor(size_t joint, CommandType type) const
+  {
+    return type == NO_COMMAND ? NULL : typedCommands_[type][joint];
+  }
+
+  /// Name of the joint command interface of a command type, as claimed by controllers
+  static std::string interfaceName(CommandType type);
+  /// Command type of a joint command interface name, NO_COMMAND if unknown
+  static CommandType fromInterfaceName(const std::string& name);
+
+  std::vector<std::string> names;
+  std::vector<double*> position;
+  std::vector<double*> velocity;
+  std::vector<double*> effort;
+  /// Command of the first command interface exposing the joint, NULL if none
+  std::vector<double*> command;
+  std::vector<CommandType> commandType;
+  std::vector<gazebo::physics::JointPtr> simJoints;
+
+private:
+  NameIndex nameIndex_;
+  std::vector<double*> typedCommands_[EFFORT_COMMAND + 1];
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_JOINT_BUFFERS_H
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_JOINT_FRICTION_H
+#define PAL_HARDWARE_GAZEBO_JOINT_FRICTION_H
+
+#include <string>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <ros/ros.h>
+#include <gazebo/physics/physics.hh>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Coulomb, viscous and Stribeck joint friction applied as an effort.
+ *
+ * For a joint velocity v the applied effort is
+ *   -(Fc + (Fs - Fc) * exp(-(v / vs)^2)) * tanh(v / eps) - b * v
+ * evaluated for all the joints at once. The tanh smoothing keeps the slope
+ * around zero velocity bounded by Fs / eps + b, unlike a stiff SDF damping.
+ * The effort adds up with the one set by the joint resource in the same step.
+ *
+ * For the explicit step not to reverse the velocity, (Fs / eps + b) * dt / I
+ * must stay below 1, I being the inertia about the joint axis and dt the
+ * physics step. eps is raised at init to the smallest value that satisfies
+ * it, and a viscous friction too large for any eps is rejected.
+ *
+ * Parameters, under "joint_friction/<joint>":
+ *  - coulomb: Fc (default 0)
+ *  - static: Fs, breakaway friction (default Fc)
+ *  - stribeck_velocity: vs (default 0.01)
+ *  - viscous: b (default 0)
+ *  - smoothing_velocity: eps (default 1e-3)
+ *  - inertia: I, defaults to the one of the child link alone, which is a
+ *    lower bound of the inertia moved by the joint
+ */
+class JointFriction
+{
+public:
+  bool init(ros::NodeHandle& nh, const std::vector<std::string>& joint_names,
+            gazebo::physics::ModelPtr model);
+
+  bool enabled() const
+  {
+    return !joints_.empty();
+  }
+
+  /// Computes and applies the friction efforts, call after writing
+  void apply();
+
+private:
+  std::vector<gazebo::physics::JointPtr> joints_;
+  Eigen::ArrayXd coulomb_;
+  Eigen::ArrayXd static_;
+  Eigen::ArrayXd stribeckVelocity_;
+  Eigen::ArrayXd viscous_;
+  Eigen::ArrayXd smoothingVelocity_;
+
+  Eigen::ArrayXd velocity_;
+  Eigen::ArrayXd effort_;
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_JOINT_FRICTION_H
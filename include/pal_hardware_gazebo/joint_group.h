@@ -0,0 +1,82 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_JOINT_GROUP_H
+#define PAL_HARDWARE_GAZEBO_JOINT_GROUP_H
+
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <pal_hardware_gazebo/joint_buffers.h>
+#include <pal_hardware_gazebo/joint_group_interface.h>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Contiguous copy of the buffers of a set of joints, commanded
+ * through one joint command interface.
+ */
+class JointGroup
+{
+public:
+  bool init(const std::string& name, const std::vector<std::string>& joint_names,
+            JointBuffers::CommandType command_type, const JointBuffers& joints);
+
+  const std::string& getName() const
+  {
+    return name_;
+  }
+
+  const std::vector<size_t>& getIndices() const
+  {
+    return indices_;
+  }
+
+  const std::vector<std::string>& getJointNames() const
+  {
+    return jointNames_;
+  }
+
+  /// Joint command interface the group commands are written through
+  const std::string& getInterfaceName() const
+  {
+    return interfaceName_;
+  }
+
+  JointGroupHandle::Data getHandleData();
+
+  /// Copies the joint states into the group arrays
+  void gatherState();
+  /// Copies the joint commands into the group command array
+  void gatherCommands();
+  /// Copies the group command array into the joint commands
+  void scatterCommands();
+
+private:
+  std::string name_;
+  std::vector<std::string> jointNames_;
+  std::vector<size_t> indices_;
+  std::string interfaceName_;
+
+  std::vector<const double*> jointPositions_;
+  std::vector<const double*> jointVelocities_;
+  std::vector<const double*> jointEfforts_;
+  std::vector<double*> jointCommands_;
+
+  std::vector<double> position_;
+  std::vector<double> velocity_;
+  std::vector<double> effort_;
+  std::vector<double> command_;
+};
+
+typedef boost::shared_ptr<JointGroup> JointGroupPtr;
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_JOINT_GROUP_H
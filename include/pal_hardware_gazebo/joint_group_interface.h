@@ -0,0 +1,94 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_JOINT_GROUP_INTERFACE_H
+#define PAL_HARDWARE_GAZEBO_JOINT_GROUP_INTERFACE_H
+
+#include <string>
+#include <vector>
+
+#include <hardware_interface/internal/hardware_resource_manager.h>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Contiguous state and command arrays of a named set of joints, in
+ * the order given by getJointNames().
+ *
+ * The state arrays are refreshed after every read and the command array is
+ * copied to the joint commands of getCommandInterface() before every write,
+ * while a controller claiming the group is running.
+ */
+class JointGroupHandle
+{
+public:
+  struct Data
+  {
+    Data() : joint_names(NULL), position(NULL), velocity(NULL), effort(NULL), command(NULL)
+    {
+    }
+
+    std::string name;
+    std::string command_interface;
+    const std::vector<std::string>* joint_names;
+    const double* position;
+    const double* velocity;
+    const double* effort;
+    double* command;
+  };
+
+  JointGroupHandle(const Data& data = Data()) : data_(data)
+  {
+  }
+
+  std::string getName() const
+  {
+    return data_.name;
+  }
+  const std::vector<std::string>& getJointNames() const
+  {
+    return *data_.joint_names;
+  }
+  /// Joint command interface the commands are written through
+  const std::string& getCommandInterface() const
+  {
+    return data_.command_interface;
+  }
+  size_t size() const
+  {
+    return data_.joint_names->size();
+  }
+  const double* getPositions() const
+  {
+    return data_.position;
+  }
+  const double* getVelocities() const
+  {
+    return data_.velocity;
+  }
+  const double* getEfforts() const
+  {
+    return data_.effort;
+  }
+  double* getCommands() const
+  {
+    return data_.command;
+  }
+
+private:
+  Data data_;
+};
+
+/// Claims the group name, the hardware layer expands it to the group joints
+class JointGroupInterface
+    : public hardware_interface::HardwareResourceManager<JointGroupHandle, hardware_interface::ClaimResources>
+{
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_JOINT_GROUP_INTERFACE_H
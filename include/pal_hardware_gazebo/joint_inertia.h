@@ -0,0 +1,29 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_JOINT_INERTIA_H
+#define PAL_HARDWARE_GAZEBO_JOINT_INERTIA_H
+
+#include <gazebo/physics/physics.hh>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Inertia of the child link of a joint about its axis, or its mass
+ * for prismatic joints, 0 if it has no inertial.
+ *
+ * The links further down the chain are left out, so this is a lower bound
+ * of the inertia moved by the joint.
+ */
+double childLinkInertia(const gazebo::physics::JointPtr& joint);
+
+/// Maximum step size of the physics engine of the world
+double physicsStepSize(const gazebo::physics::WorldPtr& world);
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_JOINT_INERTIA_H
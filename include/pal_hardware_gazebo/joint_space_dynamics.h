@@ -0,0 +1,106 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_JOINT_SPACE_DYNAMICS_H
+#define PAL_HARDWARE_GAZEBO_JOINT_SPACE_DYNAMICS_H
+
+#include <string>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/StdVector>
+
+#include <urdf/model.h>
+
+#include <pal_hardware_gazebo/joint_buffers.h>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Joint-space dynamics of the robot built from its URDF model.
+ *
+ * The root link is considered fixed to the world, joints that are not
+ * exposed through the joint buffers are locked at zero. Every term is
+ * computed on request, at most once per tick, with the joint state of the
+ * current tick: the mass matrix with the composite rigid body algorithm and
+ * the gravity and Coriolis terms with recursive Newton-Euler.
+ */
+class JointSpaceDynamics
+{
+public:
+  typedef Eigen::Matrix<double, 6, 1> SpatialVector;
+  typedef Eigen::Matrix<double, 6, 6> SpatialMatrix;
+
+  JointSpaceDynamics();
+
+  bool init(const urdf::Model& urdf_model, const JointBuffers& joints,
+            const Eigen::Vector3d& gravity);
+
+  /// Invalidates the cached terms, call once per tick after reading
+  void newTick()
+  {
+    ++tick_;
+  }
+
+  const std::vector<std::string>& getJointNames() const
+  {
+    return jointNames_;
+  }
+
+  const Eigen::MatrixXd& getMassMatrix();
+  const Eigen::VectorXd& getGravity();
+  /// Coriolis and centrifugal terms C(q, qd) * qd
+  const Eigen::VectorXd& getCoriolis();
+
+private:
+  struct Body
+  {
+    int parent;
+    int dof;
+    bool prismatic;
+    Eigen::Vector3d axis;
+    Eigen::Matrix3d originRotation;
+    Eigen::Vector3d originTranslation;
+    SpatialMatrix inertia;
+  };
+
+  void addSubtree(const urdf::Link& link, int parent, const JointBuffers& joints);
+  void readState();
+  void updateKinematics();
+  /// Recursive Newton-Euler at zero acceleration, either with gravity only or
+  /// with the velocity product terms only
+  void inverseDynamics(bool velocity_terms, Eigen::VectorXd& tau);
+
+  std::vector<Body, Eigen::aligned_allocator<Body> > bodies_;
+  std::vector<std::string> jointNames_;
+  std::vector<const double*> positions_;
+  std::vector<const double*> velocities_;
+  SpatialVector rootAcceleration_;
+
+  Eigen::VectorXd q_;
+  Eigen::VectorXd qd_;
+  std::vector<SpatialMatrix, Eigen::aligned_allocator<SpatialMatrix> > Xup_;
+  std::vector<SpatialVector, Eigen::aligned_allocator<SpatialVector> > S_;
+  std::vector<SpatialVector, Eigen::aligned_allocator<SpatialVector> > v_;
+  std::vector<SpatialVector, Eigen::aligned_allocator<SpatialVector> > a_;
+  std::vector<SpatialVector, Eigen::aligned_allocator<SpatialVector> > f_;
+  std::vector<SpatialMatrix, Eigen::aligned_allocator<SpatialMatrix> > Ic_;
+
+  Eigen::MatrixXd massMatrix_;
+  Eigen::VectorXd gravity_;
+  Eigen::VectorXd coriolis_;
+
+  unsigned long tick_;
+  unsigned long kinematicsTick_;
+  unsigned long massMatrixTick_;
+  unsigned long gravityTick_;
+  unsigned long coriolisTick_;
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_JOINT_SPACE_DYNAMICS_H
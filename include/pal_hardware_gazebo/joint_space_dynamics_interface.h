@@ -0,0 +1,79 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_JOINT_SPACE_DYNAMICS_INTERFACE_H
+#define PAL_HARDWARE_GAZEBO_JOINT_SPACE_DYNAMICS_INTERFACE_H
+
+#include <string>
+
+#include <hardware_interface/internal/hardware_resource_manager.h>
+
+#include <pal_hardware_gazebo/joint_space_dynamics.h>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Access to the joint-space dynamics terms shared by all controllers.
+ * The terms are computed lazily, the first controller asking for them in a
+ * tick pays for the computation.
+ */
+class JointSpaceDynamicsHandle
+{
+public:
+  JointSpaceDynamicsHandle() : dynamics_(NULL)
+  {
+  }
+
+  JointSpaceDynamicsHandle(const std::string& name, JointSpaceDynamics* dynamics)
+    : name_(name), dynamics_(dynamics)
+  {
+    if (!dynamics_)
+    {
+      throw hardware_interface::HardwareInterfaceException(
+          "Cannot create handle '" + name + "'. Dynamics pointer is null.");
+    }
+  }
+
+  std::string getName() const
+  {
+    return name_;
+  }
+
+  /// Order of the rows and columns of all the terms
+  const std::vector<std::string>& getJointNames() const
+  {
+    return dynamics_->getJointNames();
+  }
+
+  const Eigen::MatrixXd& getMassMatrix() const
+  {
+    return dynamics_->getMassMatrix();
+  }
+
+  const Eigen::VectorXd& getGravity() const
+  {
+    return dynamics_->getGravity();
+  }
+
+  const Eigen::VectorXd& getCoriolis() const
+  {
+    return dynamics_->getCoriolis();
+  }
+
+private:
+  std::string name_;
+  JointSpaceDynamics* dynamics_;
+};
+
+class JointSpaceDynamicsInterface
+    : public hardware_interface::HardwareResourceManager<JointSpaceDynamicsHandle>
+{
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_JOINT_SPACE_DYNAMICS_INTERFACE_H
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_KINEMATIC_BASE_H
+#define PAL_HARDWARE_GAZEBO_KINEMATIC_BASE_H
+
+#include <string>
+#include <vector>
+
+#include <ros/ros.h>
+#include <gazebo/physics/physics.hh>
+
+#include <pal_hardware_gazebo/diff_drive_geometry.h>
+#include <pal_hardware_gazebo/joint_buffers.h>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Moves a differential drive base kinematically instead of through
+ * wheel contacts.
+ *
+ * The wheel velocity commands are turned into a planar twist applied to the
+ * base link only, the joints carrying the rest of the model along. The wheel
+ * joint states are integrated from the commands. The wheel resources are
+ * neither read nor written. The wheel collisions should be disabled in the
+ * model, since they would fight the imposed motion.
+ *
+ * Parameters, under the "mobile_base" namespace, see DiffDriveGeometry for
+ * the layout:
+ *  - kinematic: defaults to false
+ *  - base_link: link the twist is applied to, defaults to the canonical link
+ */
+class KinematicBase
+{
+public:
+  KinematicBase();
+
+  bool init(ros::NodeHandle& nh, const DiffDriveGeometry& geometry, JointBuffers& joints,
+            gazebo::physics::ModelPtr model);
+
+  bool enabled() const
+  {
+    return enabled_;
+  }
+
+  /// Maps the read resources, by name, to wheels
+  void setResources(const std::vector<std::string>& names);
+  /// Maps the active write resources, by name, to wheels, call on switch
+  void setActiveResources(const std::vector<std::string>& names);
+
+  bool ownsResource(size_t resource) const
+  {
+    return ownedResources_[resource];
+  }
+  bool ownsActiveResource(size_t active_index) const
+  {
+    return active_index < ownedActiveResources_.size() && ownedActiveResources_[active_index];
+  }
+
+  /// Synthesizes the wheel joint states, call when reading
+  void read(const ros::Duration& period);
+  /// Applies the base twist, call when writing
+  void write();
+
+private:
+  bool isWheel(const std::string& name) const;
+
+  bool enabled_;
+  const DiffDriveGeometry* geometry_;
+  JointBuffers* joints_;
+  gazebo::physics::LinkPtr baseLink_;
+  std::vector<size_t> wheels_;
+  /// Integrated wheel angles, kept apart from the buffers that emulation quantizes
+  std::vector<double> wheelPositions_;
+  std::vector<char> ownedResources_;
+  std::vector<char> ownedActiveResources_;
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_KINEMATIC_BASE_H
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_LAZY_JOINT_READER_H
+#define PAL_HARDWARE_GAZEBO_LAZY_JOINT_READER_H
+
+#include <string>
+#include <vector>
+
+#include <hardware_interface/internal/hardware_resource_manager.h>
+#include <ros/ros.h>
+
+#include <pal_hardware_gazebo/joint_buffers.h>
+#include <pal_hardware_gazebo/resource_bitset.h>
+
+namespace gazebo_ros_control
+{
+class LazyJointReader;
+
+/**
+ * @brief Lets a consumer of an unclaimed joint ask for it to be read.
+ */
+class JointReadRequestHandle
+{
+public:
+  JointReadRequestHandle() : reader_(NULL), joint_(0)
+  {
+  }
+
+  JointReadRequestHandle(const std::string& name, LazyJointReader* reader, size_t joint)
+    : name_(name), reader_(reader), joint_(joint)
+  {
+  }
+
+  std::string getName() const
+  {
+    return name_;
+  }
+
+  /// Reads the joint on the next tick only
+  void requestRead();
+  /// Reads the joint on every tick until released
+  void pin();
+  void release();
+
+private:
+  std::string name_;
+  LazyJointReader* reader_;
+  size_t joint_;
+};
+
+class JointReadRequestInterface
+    : public hardware_interface::HardwareResourceManager<JointReadRequestHandle>
+{
+};
+
+/**
+ * @brief Decides which joint resources are read on every tick.
+ *
+ * Joints claimed by the running controllers, pinned or requested through a
+ * JointReadRequestHandle, or consumed by the plugin itself are read on every
+ * tick. The others are refreshed once every background_divider ticks,
+ * staggered so that the cost is spread evenly, or never if it is 0.
+ *
+ * Controllers that only read joint states, like joint_state_controller,
+ * claim no resources: they get background refreshes only, unless they pin
+ * their joints through the JointReadRequestInterface or the joints are
+ * listed in always_read.
+ *
+ * Parameters, under the "lazy_read" namespace:
+ *  - enabled (default false)
+ *  - background_divider (default 10)
+ *  - always_read: joints read on every tick regardless of claims
+ */
+class LazyJointReader
+{
+public:
+  LazyJointReader();
+
+  bool init(ros::NodeHandle& nh, const JointBuffers& joints);
+
+  bool enabled() const
+  {
+    return enabled_;
+  }
+
+  /// Joints the plugin itself needs on every tick
+  void addConsumed(size_t joint);
+  void addAllConsumed();
+
+  /// Maps the read resources, by name, to joints
+  void setResources(const std::vector<std::string>& names);
+
+  /// Recomputes the joints read on every tick, call on switch
+  void update(const ResourceBitset& claimed);
+
+  /// Advances the background refresh, call once per tick before reading
+  void newTick();
+
+  /// Whether the given resource must be read this tick
+  bool shouldRead(size_t resource)
+  {
+    const int joint = resourceJoints_[resource];
+    if (joint < 0 || referenced_.test(joint))
+    {
+      return true;
+    }
+    if (requested_[joint])
+    {
+      requested_[joint] = 0;
+      return true;
+    }
+    const unsigned int divider = backgroundDivider_ * backgroundFactor_;
+    return divider > 0 && (tick_ + resource) % divider == 0;
+  }
+
+  void requestRead(size_t joint)
+  {
+    requested_[joint] = 1;
+  }
+  void pin(size_t joint);
+  void release(size_t joint);
+
+  void registerHandles(JointReadRequestInterface& iface);
+
+  /// Refreshes the other joints factor times less often, 1 to restore
+  void setBackgroundFactor(unsigned int factor)
+  {
+    backgroundFactor_ = factor;
+  }
+
+private:
+  bool enabled_;
+  unsigned int backgroundDivider_;
+  unsigned int backgroundFactor_;
+  unsigned long tick_;
+
+  const JointBuffers* joints_;
+  std::vector<int> resourceJoints_;
+  ResourceBitset consumed_;
+  ResourceBitset claimed_;
+  ResourceBitset referenced_;
+  std::vector<int> pinCount_;
+  std::vector<char> requested_;
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_LAZY_JOINT_READER_H
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_LOAD_SHEDDER_H
+#define PAL_HARDWARE_GAZEBO_LOAD_SHEDDER_H
+
+#include <string>
+#include <vector>
+
+#include <boost/chrono.hpp>
+#include <boost/function.hpp>
+
+#include <ros/ros.h>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Degrades optional work while the hardware layer runs over its
+ * tick budget, and restores it once there is headroom again.
+ *
+ * The cost of a tick is the time spent reading and writing, the controller
+ * update excluded. Ticks are evaluated in windows. When more than
+ * overrun_ratio of the ticks of a window went over budget, the next task is
+ * shed, in the order they were added. After recover_windows windows in a
+ * row without overruns and with a mean cost under headroom times the
+ * budget, the last shed task is restored. Every change is logged.
+ *
+ * Parameters, under the "load_shedding" namespace:
+ *  - enabled: defaults to false
+ *  - budget: seconds per tick, defaults to budget_fraction of the period
+ *  - budget_fraction: defaults to 0.5
+ *  - window_ticks: defaults to 100
+ *  - overrun_ratio: defaults to 0.2
+ *  - headroom: defaults to 0.7
+ *  - recover_windows: defaults to 5
+ *  - shed_factor: rate divider applied to shed tasks, defaults to 4
+ */
+class LoadShedder
+{
+public:
+  /// Sets the rate divider of a task, 1 when it runs normally
+  typedef boost::function<void(unsigned int)> FactorSetter;
+
+  LoadShedder();
+
+  bool init(ros::NodeHandle& nh);
+
+  bool enabled() const
+  {
+    return enabled_;
+  }
+
+  void addTask(const std::string& name, const FactorSetter& setter);
+
+  /// Brackets a read or write phase
+  void startPhase()
+  {
+    phaseStart_ = boost::chrono::steady_clock::now();
+  }
+  void stopPhase()
+  {
+    tickCost_ += boost::chrono::steady_clock::now() - phaseStart_;
+  }
+
+  /// Accounts the cost of the finished tick, call at the end of writing
+  void endTick(const ros::Duration& period);
+
+  size_t shedTasks() const
+  {
+    return level_;
+  }
+
+private:
+  struct Task
+  {
+    std::string name;
+    FactorSetter setter;
+  };
+
+  void endWindow();
+
+  bool enabled_;
+  double budget_;
+  double budgetFraction_;
+  int windowTicks_;
+  double overrunRatio_;
+  double headroom_;
+  int recoverWindows_;
+  unsigned int shedFactor_;
+
+  std::vector<Task> tasks_;
+  size_t level_;
+
+  boost::chrono::steady_clock::time_point phaseStart_;
+  boost::chrono::steady_clock::duration tickCost_;
+  int ticks_;
+  int overruns_;
+  double windowCost_;
+  double windowBudget_;
+  int calmWindows_;
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_LOAD_SHEDDER_H
@@ -0,0 +1,195 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_METRICS_EXPORTER_H
+#define PAL_HARDWARE_GAZEBO_METRICS_EXPORTER_H
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <boost/chrono.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <ros/ros.h>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Latency histogram with fixed buckets, updated without locking.
+ */
+class LatencyHistogram
+{
+public:
+  LatencyHistogram();
+
+  void observe(const boost::chrono::steady_clock::duration& latency);
+
+  /// Writes the histogram in the Prometheus text format, from any thread
+  void render(std::ostream& out, const std::string& name, const std::string& labels) const;
+
+private:
+  static const size_t BUCKETS = 12;
+  static const double BOUNDS[BUCKETS];
+
+  /// Per bucket, not cumulative, the last one being +Inf
+  std::atomic<uint64_t> counts_[BUCKETS + 1];
+  std::atomic<uint64_t> sumNs_;
+};
+
+class MetricsExporter;
+
+/**
+ * @brief HTTP listener shared by the metrics exporters of a process that
+ * use the same port, each one rendering the metrics of its robot.
+ */
+class MetricsServer
+{
+public:
+  /// Returns the server of the port, started by the first caller, or null
+  /// if the port could not be bound
+  static boost::shared_ptr<MetricsServer> forPort(int port);
+
+  ~MetricsServer();
+
+  void add(const MetricsExporter* exporter);
+  void remove(const MetricsExporter* exporter);
+
+private:
+  MetricsServer();
+
+  bool start(int port);
+  void serve();
+  void render(std::ostream& out);
+
+  boost::mutex mutex_;
+  std::vector<const MetricsExporter*> exporters_;
+
+  int socket_;
+  std::atomic<bool> running_;
+  boost::thread serverThread_;
+};
+
+/**
+ * @brief Serves the metrics of the hardware layer in the Prometheus text
+ * format, over HTTP on a localhost port.
+ *
+ * The simulation thread only updates atomic counters and histograms, which
+ * a background thread reads when scraped. Metrics, labelled with the robot
+ * namespace, all the robots of a process being served on the same port:
+ *  - pal_hardware_gazebo_tick_phase_seconds{phase}: cost of the read and
+ *    write phases, the waits for other processes excluded
+ *  - pal_hardware_gazebo_ticks_total
+ *  - pal_hardware_gazebo_tick_overruns_total: ticks whose read and write
+ *    cost went over budget
+ *  - pal_hardware_gazebo_controller_switch_seconds: from the switch being
+ *    accepted to it being done on the simulation thread
+ *  - pal_hardware_gazebo_sensor_unchanged_ticks{sensor} and
+ *    pal_hardware_gazebo_sensor_health_flags{sensor}, with sensor health
+ *
+ * Parameters, under the "metrics" namespace:
+ *  - enabled: defaults to false
+ *  - port: TCP port on 127.0.0.1, defaults to 9464. If it can not be bound
+ *    the metrics are not served, which is only warned about.
+ *  - budget: seconds per tick, defaults to budget_fraction of the period
+ *  - budget_fraction: defaults to 0.5
+ */
+class MetricsExporter
+{
+public:
+  enum Phase
+  {
+    READ_PHASE,
+    WRITE_PHASE,
+    PHASE_COUNT
+  };
+
+  MetricsExporter();
+  ~MetricsExporter();
+
+  /// Starts serving, sensor_names are those reported with setSensorHealth()
+  bool init(ros::NodeHandle& nh, const std::string& robot,
+            const std::vector<std::string>& sensor_names);
+
+  bool enabled() const
+  {
+    return enabled_;
+  }
+
+  /// Brackets a read or write phase
+  void startPhase()
+  {
+    phaseStart_ = boost::chrono::steady_clock::now();
+  }
+  void stopPhase(Phase phase)
+  {
+    const boost::chrono::steady_clock::duration cost =
+        boost::chrono::steady_clock::now() - phaseStart_;
+    phases_[phase].observe(cost);
+    tickCost_ += cost;
+  }
+
+  /// Accounts the cost of the finished tick, call at the end of writing
+  void endTick(const ros::Duration& period);
+
+  /// Called once a controller switch is accepted, from any thread
+  void switchRequested();
+  /// Called once the switch is done
+  void switchDone();
+
+  void setSensorHealth(size_t sensor, unsigned int flags, int unchanged_ticks)
+  {
+    sensorFlags_[sensor].store(flags, std::memory_order_relaxed);
+    sensorUnchangedTicks_[sensor].store(unchanged_ticks, std::memory_order_relaxed);
+  }
+
+  enum Family
+  {
+    TICK_PHASE_SECONDS,
+    TICKS_TOTAL,
+    TICK_OVERRUNS_TOTAL,
+    CONTROLLER_SWITCH_SECONDS,
+    SENSOR_UNCHANGED_TICKS,
+    SENSOR_HEALTH_FLAGS,
+    FAMILY_COUNT
+  };
+
+  /// Writes the "# TYPE" line of a metric family
+  static void renderType(std::ostream& out, Family family);
+  /// Writes the samples of a metric family, from any thread
+  void render(std::ostream& out, Family family) const;
+
+private:
+  bool enabled_;
+  std::string labels_;
+  double budget_;
+  double budgetFraction_;
+
+  LatencyHistogram phases_[PHASE_COUNT];
+  LatencyHistogram switchLatency_;
+  std::atomic<uint64_t> ticks_;
+  std::atomic<uint64_t> overruns_;
+  boost::chrono::steady_clock::time_point phaseStart_;
+  boost::chrono::steady_clock::duration tickCost_;
+  /// Steady clock time of the pending switch request in nanoseconds, 0 if none
+  std::atomic<int64_t> switchRequestNs_;
+
+  std::vector<std::string> sensorNames_;
+  boost::scoped_array<std::atomic<unsigned int> > sensorFlags_;
+  boost::scoped_array<std::atomic<int> > sensorUnchangedTicks_;
+
+  boost::shared_ptr<MetricsServer> server_;
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_METRICS_EXPORTER_H
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_MIMIC_JOINTS_H
+#define PAL_HARDWARE_GAZEBO_MIMIC_JOINTS_H
+
+#include <string>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <ros/ros.h>
+#include <urdf/model.h>
+#include <gazebo/physics/physics.hh>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Enforces the URDF <mimic> relations of the model with PD tracking.
+ *
+ * Every follower joint tracks multiplier * leader + offset. The tracking
+ * effort of all the followers is computed at once, and the opposite effort
+ * scaled by the multiplier is applied to the leader, as a gear would.
+ *
+ * The gains are per unit of inertia of the follower, so that the same
+ * values track as fast on light fingers as on heavy links. The explicit
+ * step stays stable while kd * dt and kp * dt^2 are below 1, dt being the
+ * physics step, which is checked at init.
+ *
+ * Parameters, under the "mimic_joints" namespace:
+ *  - enabled (default false), disable the Gazebo mimic plugins when set
+ *  - kp, kd: default gains (1e4, 200), critically damped
+ *  - <joint>/kp, <joint>/kd: gains of a given follower
+ *  - <joint>/inertia: inertia of a given follower, defaults to the one of
+ *    its child link
+ */
+class MimicJoints
+{
+public:
+  MimicJoints();
+
+  bool init(ros::NodeHandle& nh, const urdf::Model& urdf_model, gazebo::physics::ModelPtr model);
+
+  bool enabled() const
+  {
+    return enabled_;
+  }
+
+  /// Computes and applies the tracking efforts, call after writing
+  void apply();
+
+private:
+  bool enabled_;
+
+  std::vector<gazebo::physics::JointPtr> followers_;
+  std::vector<gazebo::physics::JointPtr> leaders_;
+  Eigen::ArrayXd multiplier_;
+  Eigen::ArrayXd offset_;
+  Eigen::ArrayXd kp_;
+  Eigen::ArrayXd kd_;
+
+  Eigen::ArrayXd leaderPosition_;
+  Eigen::ArrayXd leaderVelocity_;
+  Eigen::ArrayXd followerPosition_;
+  Eigen::ArrayXd followerVelocity_;
+  Eigen::ArrayXd effort_;
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_MIMIC_JOINTS_H
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_NAME_INDEX_H
+#define PAL_HARDWARE_GAZEBO_NAME_INDEX_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Static map from names to their position in a list, built once with
+ * a perfect hash.
+ *
+ * Names are first hashed to a bucket, each bucket stores the seed of a
+ * second hash that sends all of its names to distinct slots. A lookup costs
+ * two hashes and a single string comparison, which rejects unknown names.
+ */
+class NameIndex
+{
+public:
+  NameIndex();
+
+  /// Builds the index, returns false if @p names has duplicates
+  bool build(const std::vector<std::string>& names);
+
+  /// Position of @p name in the list given to build(), -1 if unknown
+  int find(const std::string& name) const;
+
+  size_t size() const
+  {
+    return names_.size();
+  }
+
+  /// Names in the order given to build()
+  const std::vector<std::string>& names() const
+  {
+    return names_;
+  }
+
+private:
+  static uint64_t hash(const std::string& name, uint64_t seed);
+  bool tryBuild(size_t table_size);
+
+  std::vector<std::string> names_;
+  std::vector<uint32_t> seeds_;
+  std::vector<int> slots_;
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_NAME_INDEX_H
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_NAME_INDEX_INTERFACE_H
+#define PAL_HARDWARE_GAZEBO_NAME_INDEX_INTERFACE_H
+
+#include <string>
+
+#include <hardware_interface/internal/hardware_resource_manager.h>
+
+#include <pal_hardware_gazebo/name_index.h>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Read-only access to one of the name indices built at initSim.
+ *
+ * Available indices: "joints", in the order of the joint state interface
+ * names, "force_torque_sensors", "imu_sensors" and "joint_groups".
+ */
+class NameIndexHandle
+{
+public:
+  NameIndexHandle() : index_(NULL)
+  {
+  }
+
+  NameIndexHandle(const std::string& name, const NameIndex* index) : name_(name), index_(index)
+  {
+    if (!index_)
+    {
+      throw hardware_interface::HardwareInterfaceException(
+          "Cannot create handle '" + name + "'. Index pointer is null.");
+    }
+  }
+
+  std::string getName() const
+  {
+    return name_;
+  }
+
+  /// Position of @p name, -1 if unknown
+  int find(const std::string& name) const
+  {
+    return index_->find(name);
+  }
+
+  const std::vector<std::string>& getNames() const
+  {
+    return index_->names();
+  }
+
+private:
+  std::string name_;
+  const NameIndex* index_;
+};
+
+class NameIndexInterface : public hardware_interface::HardwareResourceManager<NameIndexHandle>
+{
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_NAME_INDEX_INTERFACE_H
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_ODOMETRY_INTERFACE_H
+#define PAL_HARDWARE_GAZEBO_ODOMETRY_INTERFACE_H
+
+#include <string>
+
+#include <hardware_interface/internal/hardware_resource_manager.h>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Planar pose and twist of the mobile base integrated from the wheel
+ * velocities. The pose is expressed in the odometry frame, the twist in the
+ * base frame.
+ */
+class OdometryHandle
+{
+public:
+  struct Data
+  {
+    Data() : x(NULL), y(NULL), yaw(NULL), linear(NULL), angular(NULL)
+    {
+    }
+
+    std::string name;
+    std::string frame_id;
+    std::string child_frame_id;
+    const double* x;
+    const double* y;
+    const double* yaw;
+    const double* linear;
+    const double* angular;
+  };
+
+  OdometryHandle(const Data& data = Data()) : data_(data)
+  {
+  }
+
+  std::string getName() const
+  {
+    return data_.name;
+  }
+  std::string getFrameId() const
+  {
+    return data_.frame_id;
+  }
+  std::string getChildFrameId() const
+  {
+    return data_.child_frame_id;
+  }
+  double getX() const
+  {
+    return *data_.x;
+  }
+  double getY() const
+  {
+    return *data_.y;
+  }
+  double getYaw() const
+  {
+    return *data_.yaw;
+  }
+  double getLinearVelocity() const
+  {
+    return *data_.linear;
+  }
+  double getAngularVelocity() const
+  {
+    return *data_.angular;
+  }
+
+private:
+  Data data_;
+};
+
+class OdometryInterface : public hardware_interface::HardwareResourceManager<OdometryHandle>
+{
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_ODOMETRY_INTERFACE_H
@@ -27,9 +27,36 @@
 
 #include <gazebo/physics/physics.hh>
 #include <gazebo/sensors/ImuSensor.hh>
+#include <gazebo/sensors/ForceTorqueSensor.hh>
 
 #include <gazebo_ros_control/default_robot_hw_sim.h>
 
+#include <pal_hardware_gazebo/joint_buffers.h>
+#include <pal_hardware_gazebo/controller_claims.h>
+#include <pal_hardware_gazebo/joint_group.h>
+#include <pal_hardware_gazebo/name_index_interface.h>
+#include <pal_hardware_gazebo/hardware_emulation.h>
+#include <pal_hardware_gazebo/write_skipper.h>
+#include <pal_hardware_gazebo/lazy_joint_reader.h>
+#include <pal_hardware_gazebo/joint_friction.h>
+#include <pal_hardware_gazebo/mimic_joints.h>
+#include <pal_hardware_gazebo/kinematic_base.h>
+#include <pal_hardware_gazebo/wheel_odometry.h>
+#include <pal_hardware_gazebo/grasp_manager.h>
+#include <pal_hardware_gazebo/hardware_scheduler.h>
+#include <pal_hardware_gazebo/controller_host.h>
+#include <pal_hardware_gazebo/co_simulation.h>
+#include <pal_hardware_gazebo/policy_hook.h>
+#include <pal_hardware_gazebo/floating_base_state.h>
+#include <pal_hardware_gazebo/batched_environment.h>
+#include <pal_hardware_gazebo/load_shedder.h>
+#include <pal_hardware_gazebo/sensor_health.h>
+#include <pal_hardware_gazebo/metrics_exporter.h>
+#include <pal_hardware_gazebo/joint_space_dynamics_interface.h>
+#include <pal_hardware_gazebo/center_of_mass_state.h>
+#include <pal_hardware_gazebo/columnar_exporter.h>
+#include <pal_hardware_gazebo/sensor_stream_recorder.h>
+
 typedef Eigen::Isometry3d eMatrixHom;
 
 namespace gazebo_ros_control
@@ -38,6 +65,10 @@ namespace gazebo_ros_control
   class ForceTorqueSensorDefinition{
   public:
       gazebo::physics::JointPtr gazebo_joint;
+      /// SDF sensor on the same joint whose output is consumed instead of computing the wrench
+      std::shared_ptr<gazebo::sensors::ForceTorqueSensor> gazebo_ft_sensor;
+      /// Rotates the SDF sensor output to the joint wrench, in the child link frame
+      Eigen::Matrix3d sdfToChild;
       std::string sensorName;
       std::string sensorJointName;
       std::string sensorFrame;
@@ -85,11 +116,12 @@ namespace gazebo_ros_control
 
   typedef boost::shared_ptr<ImuSensorDefinition> ImuSensorDefinitionPtr;
 
-class PalHardwareGazebo : public DefaultRobotHWSim
+class PalHardwareGazebo : public DefaultRobotHWSim, public ScheduledHardware
 {
 public:
 
   PalHardwareGazebo();
+  ~PalHardwareGazebo();
 
   // Simulation-specific
   bool initSim(const std::string& robot_ns,
@@ -100,16 +132,91 @@ public:
   void readSim(ros::Time time, ros::Duration period);
   void writeSim(ros::Time time, ros::Duration period);
 
+  // Hardware phases, called from readSim/writeSim or from the world scheduler
+  void readHardware(const ros::Time& time, const ros::Duration& period);
+  void writeHardware(const ros::Time& time, const ros::Duration& period);
+  void readSerial(const ros::Time& time, const ros::Duration& period);
+  void writeSerial(const ros::Time& time, const ros::Duration& period);
+
+  // Controller switching
+  bool checkForConflict(const std::list<hardware_interface::ControllerInfo>& info) const;
+  bool prepareSwitch(const std::list<hardware_interface::ControllerInfo>& start_list,
+                     const std::list<hardware_interface::ControllerInfo>& stop_list);
+  void doSwitch(const std::list<hardware_interface::ControllerInfo>& start_list,
+                const std::list<hardware_interface::ControllerInfo>& stop_list);
+
 private:
 
   bool parseForceTorqueSensors(ros::NodeHandle &nh,
                                gazebo::physics::ModelPtr model,
                                const urdf::Model* const urdf_model);
 
+  /// Finds the SDF force_torque sensors of the model and reports, disables or consumes the
+  /// ones that duplicate a parsed sensor. Must run before the FT handles are registered.
+  /// A consumed sensor output is rotated back to the child link of its joint, following its
+  /// <frame> and <measure_direction>; sensors measuring in the parent link are computed instead.
+  void discoverForceTorqueSensors(ros::NodeHandle &nh, gazebo::physics::ModelPtr model);
+
   bool parseIMUSensors(ros::NodeHandle &nh,
                        gazebo::physics::ModelPtr model,
                        const urdf::Model* const urdf_model);
 
+  bool parseJointGroups(ros::NodeHandle& nh);
+  /// Replaces the group claims by claims of the group joints on the group interface
+  std::list<hardware_interface::ControllerInfo>
+  expandGroupClaims(const std::list<hardware_interface::ControllerInfo>& controllers) const;
+  /// Sets the control method of the joints claimed by the controllers, from the claimed
+  /// interface when started and to NO_COMMAND when stopped
+  void updateControlMethods(const std::list<hardware_interface::ControllerInfo>& controllers,
+                            bool started);
+  bool registerNameIndices();
+  /// Names of the read resources, in the order they are read
+  std::vector<std::string> resourceNames() const;
+  /// Resources written on every tick
+  const RwResources& writtenResources() const;
+  /// Names of the active write resources, in the order they are written
+  std::vector<std::string> activeResourceNames() const;
+
+  void readResources(const ros::Time& time, const ros::Duration& period);
+  /// Reads the force-torque and IMU sensors
+  void readSensors();
+  /// Reads the observed state after a batched step, without hardware emulation
+  void refreshBatchObservation(const ros::Time& time);
+  void writeResources(const ros::Time& time, const ros::Duration& period);
+
+  bool initMobileBase(ros::NodeHandle& nh, gazebo::physics::ModelPtr model);
+  bool initLazyRead(ros::NodeHandle& nh);
+  /// Command of every interface exposing a joint, named <joint>/<interface>_command
+  void collectCommandChannels(std::vector<double*>& commands,
+                              std::vector<std::string>& names) const;
+  bool initControllerHost(ros::NodeHandle& nh, const std::string& robot_ns);
+  bool initCoSimulation(ros::NodeHandle& nh, const std::string& robot_ns);
+  /// Sensor and floating base channels
+  void collectObservationChannels(std::vector<double*>& channels,
+                                  std::vector<std::string>& names);
+  bool initPolicy(ros::NodeHandle& nh);
+  /// Writes the joints of the command channels through the channel interfaces, as if
+  /// claimed by a controller named owner that is never stopped
+  bool reserveCommandChannels(const std::string& owner, const std::vector<std::string>& channels);
+  bool initBatchedStep(ros::NodeHandle& nh, gazebo::physics::ModelPtr model);
+  void initScheduling(ros::NodeHandle& nh, gazebo::physics::ModelPtr model);
+  bool initLoadShedding(ros::NodeHandle& nh);
+  bool initSensorHealth(ros::NodeHandle& nh);
+  bool initMetrics(ros::NodeHandle& nh, const std::string& robot_ns);
+  /// Publishes the introspection data factor times less often, 1 to restore
+  void setIntrospectionFactor(unsigned int factor);
+  /// Registers the sensor and command channels with dynamic_introspection, by pointer
+  void registerIntrospection(ros::NodeHandle& nh);
+
+  /// Pointers to every joint state, FT and IMU value, in a fixed order
+  void collectSensorChannels();
+  void addSensorChannel(const std::string& name, double* value);
+
+  bool initColumnarExport(ros::NodeHandle& nh);
+  bool initSensorRecording(ros::NodeHandle& nh);
+
+  bool initJointSpaceDynamics(ros::NodeHandle& nh, const urdf::Model* const urdf_model);
+
   // Simulation-specific
   //std::vector<gazebo::physics::JointPtr> sim_joints_;
   //gazebo::physics::JointPtr right_ankle_;
@@ -118,9 +225,68 @@ private:
   // Hardware interface: sensors
   hardware_interface::ForceTorqueSensorInterface ft_sensor_interface_;
   hardware_interface::ImuSensorInterface         imu_sensor_interface_;
+  JointSpaceDynamicsInterface                    joint_space_dynamics_interface_;
+  CenterOfMassInterface                          center_of_mass_interface_;
+  JointGroupInterface                            joint_group_interface_;
+  NameIndexInterface                             name_index_interface_;
+  JointReadRequestInterface                      joint_read_request_interface_;
+  OdometryInterface                              odometry_interface_;
+  SensorHealthInterface                          sensor_health_interface_;
 
   std::vector<ForceTorqueSensorDefinitionPtr> forceTorqueSensorDefinitions_;
   std::vector<ImuSensorDefinitionPtr> imuSensorDefinitions_;
+  NameIndex forceTorqueSensorIndex_;
+  NameIndex imuSensorIndex_;
+
+  JointBuffers jointBuffers_;
+  ControllerClaims controllerClaims_;
+  std::vector<JointGroupPtr> jointGroups_;
+  std::vector<double*> sensorChannels_;
+  std::vector<std::string> sensorChannelNames_;
+
+  HardwareEmulation hardwareEmulation_;
+  SensorHealth sensorHealth_;
+  WriteSkipper writeSkipper_;
+  /// Interface each joint is commanded through by the running controllers
+  std::vector<JointBuffers::CommandType> activeControlMethods_;
+  /// Claims of the command channels driven by the plugin itself
+  std::list<hardware_interface::ControllerInfo> reservedClaims_;
+  LazyJointReader lazyJointReader_;
+  JointFriction jointFriction_;
+  MimicJoints mimicJoints_;
+  DiffDriveGeometry diffDriveGeometry_;
+  KinematicBase kinematicBase_;
+  WheelOdometry wheelOdometry_;
+  GraspManager graspManager_;
+
+  bool jointSpaceDynamicsEnabled_;
+  JointSpaceDynamics jointSpaceDynamics_;
+
+  bool centerOfMassEnabled_;
+  CenterOfMassState centerOfMassState_;
+
+  ColumnarExporter columnarExporter_;
+  SensorStreamRecorder sensorStreamRecorder_;
+
+  boost::shared_ptr<HardwareScheduler> scheduler_;
+  ControllerHost controllerHost_;
+  CoSimulation coSimulation_;
+  FloatingBaseState floatingBaseState_;
+  bool floatingBaseStateUsed_;
+  PolicyHook policyHook_;
+
+  boost::shared_ptr<BatchedEnvironment> batchedEnvironment_;
+  size_t batchedSlot_;
+  ros::Duration batchReadPeriod_;
+  ChannelLayout batchObservationLayout_;
+  ChannelLayout batchActionLayout_;
+
+  LoadShedder loadShedder_;
+  unsigned int introspectionFactor_;
+  unsigned int introspectionTicks_;
+  std::vector<std::string> registeredVariables_;
+
+  MetricsExporter metrics_;
 
 };
 
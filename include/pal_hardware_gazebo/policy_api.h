@@ -0,0 +1,42 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_POLICY_API_H
+#define PAL_HARDWARE_GAZEBO_POLICY_API_H
+
+/*
+ * C interface of the policy libraries loaded by the policy hook. A library
+ * exports the three functions below. pal_policy_step is called from the
+ * simulation thread on every tick and should neither block nor allocate.
+ */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Creates a policy for the given sizes, returns NULL on failure */
+typedef void* (*pal_policy_create_fn)(const char* config, size_t observation_size,
+                                      size_t action_size);
+
+/** Computes the action from the observation, returns 0 on success */
+typedef int (*pal_policy_step_fn)(void* policy, double time, const double* observation,
+                                  double* action);
+
+typedef void (*pal_policy_destroy_fn)(void* policy);
+
+#define PAL_POLICY_CREATE_SYMBOL "pal_policy_create"
+#define PAL_POLICY_STEP_SYMBOL "pal_policy_step"
+#define PAL_POLICY_DESTROY_SYMBOL "pal_policy_destroy"
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PAL_HARDWARE_GAZEBO_POLICY_API_H */
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_POLICY_HOOK_H
+#define PAL_HARDWARE_GAZEBO_POLICY_HOOK_H
+
+#include <string>
+#include <vector>
+
+#include <ros/ros.h>
+
+#include <pal_hardware_gazebo/channel_layout.h>
+#include <pal_hardware_gazebo/policy_api.h>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Runs a policy loaded from a shared library in the simulation
+ * thread, see policy_api.h for its interface.
+ *
+ * The observation is gathered and the policy stepped after reading; the
+ * action is scattered into the joint commands before writing. Nothing is
+ * allocated on the way.
+ *
+ * The observation can use the sensor and floating base channels.
+ *
+ * Parameters, under the "policy" namespace:
+ *  - library: path of the policy library, the hook is disabled without it
+ *  - config: string passed to the policy on creation
+ *  - observations: channels of the observation vector, in order
+ *  - actions: command channels set from the action vector, in order. Their
+ *    joints are written through the action interface whether or not a
+ *    controller runs, and controllers claiming them are rejected.
+ */
+class PolicyHook
+{
+public:
+  PolicyHook();
+  ~PolicyHook();
+
+  bool init(ros::NodeHandle& nh, const std::vector<std::string>& channel_names,
+            const std::vector<double*>& channels,
+            const std::vector<std::string>& command_names, const std::vector<double*>& commands);
+
+  bool enabled() const
+  {
+    return policy_ != NULL;
+  }
+
+  /// Gathers the observation and steps the policy, call after reading
+  void step(const ros::Time& time);
+  /// Sets the commands from the last action, call before writing
+  void apply();
+
+  const ChannelLayout& observationLayout() const
+  {
+    return observationLayout_;
+  }
+  const ChannelLayout& actionLayout() const
+  {
+    return actionLayout_;
+  }
+
+private:
+  void* library_;
+  void* policy_;
+  pal_policy_step_fn step_;
+  pal_policy_destroy_fn destroy_;
+
+  ChannelLayout observationLayout_;
+  ChannelLayout actionLayout_;
+  std::vector<double> observation_;
+  std::vector<double> action_;
+  bool actionValid_;
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_POLICY_HOOK_H
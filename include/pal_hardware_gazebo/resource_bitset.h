@@ -0,0 +1,122 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_RESOURCE_BITSET_H
+#define PAL_HARDWARE_GAZEBO_RESOURCE_BITSET_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Set of resource indices stored as 64 bit words.
+ */
+class ResourceBitset
+{
+public:
+  ResourceBitset() : size_(0)
+  {
+  }
+
+  explicit ResourceBitset(size_t size) : words_((size + 63) / 64, 0), size_(size)
+  {
+  }
+
+  size_t size() const
+  {
+    return size_;
+  }
+
+  void set(size_t i)
+  {
+    words_[i / 64] |= uint64_t(1) << (i % 64);
+  }
+
+  void reset(size_t i)
+  {
+    words_[i / 64] &= ~(uint64_t(1) << (i % 64));
+  }
+
+  bool test(size_t i) const
+  {
+    return (words_[i / 64] >> (i % 64)) & 1;
+  }
+
+  void clear()
+  {
+    for (size_t w = 0; w < words_.size(); ++w)
+    {
+      words_[w] = 0;
+    }
+  }
+
+  bool any() const
+  {
+    for (size_t w = 0; w < words_.size(); ++w)
+    {
+      if (words_[w])
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool intersects(const ResourceBitset& other) const
+  {
+    for (size_t w = 0; w < words_.size(); ++w)
+    {
+      if (words_[w] & other.words_[w])
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// Lowest index set in both sets, size() if none
+  size_t firstCommon(const ResourceBitset& other) const
+  {
+    for (size_t w = 0; w < words_.size(); ++w)
+    {
+      const uint64_t common = words_[w] & other.words_[w];
+      if (common)
+      {
+        return w * 64 + __builtin_ctzll(common);
+      }
+    }
+    return size_;
+  }
+
+  ResourceBitset& operator|=(const ResourceBitset& other)
+  {
+    for (size_t w = 0; w < words_.size(); ++w)
+    {
+      words_[w] |= other.words_[w];
+    }
+    return *this;
+  }
+
+  /// Removes all the indices of @p other from this set
+  ResourceBitset& subtract(const ResourceBitset& other)
+  {
+    for (size_t w = 0; w < words_.size(); ++w)
+    {
+      words_[w] &= ~other.words_[w];
+    }
+    return *this;
+  }
+
+private:
+  std::vector<uint64_t> words_;
+  size_t size_;
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_RESOURCE_BITSET_H
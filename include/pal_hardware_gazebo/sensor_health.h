@@ -0,0 +1,115 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_SENSOR_HEALTH_H
+#define PAL_HARDWARE_GAZEBO_SENSOR_HEALTH_H
+
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <Eigen/Core>
+
+#include <ros/ros.h>
+#include <diagnostic_msgs/DiagnosticArray.h>
+#include <realtime_tools/realtime_publisher.h>
+
+#include <pal_hardware_gazebo/sensor_health_interface.h>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Checks every sensor channel on each tick for non finite values,
+ * saturation and staleness, with whole-array operations.
+ *
+ * Channels are named <sensor>/<value>, and the flags of a sensor are those
+ * of its channels or'ed together, except for staleness: a sensor is stale
+ * when none of its values changed for stale_ticks, which is the same
+ * unchanged tick count it reports.
+ *
+ * Parameters, under the "sensor_health" namespace:
+ *  - enabled: defaults to false
+ *  - saturation_prefixes, saturation_limits: absolute limit of the channels
+ *    whose name starts with each prefix, the longest prefix wins. Channels
+ *    are unlimited by default.
+ *  - stale_ticks: ticks a value can stay exactly the same, 0 to not check
+ *    (default 0)
+ *  - stale_channels: prefixes of the channels whose sensor is checked for
+ *    staleness, defaults to the given ones
+ *  - publish_divider: ticks between diagnostics, 0 to not publish (default 100)
+ */
+class SensorHealth
+{
+public:
+  SensorHealth();
+
+  bool init(ros::NodeHandle& nh, const std::vector<std::string>& names,
+            const std::vector<double*>& channels,
+            const std::vector<std::string>& default_stale_prefixes);
+
+  bool enabled() const
+  {
+    return enabled_;
+  }
+
+  /// Checks the current values, call after reading
+  void update(const ros::Time& time);
+
+  void registerHandles(SensorHealthInterface& iface) const;
+
+  size_t sensorCount() const
+  {
+    return sensors_.size();
+  }
+  const std::string& sensorName(size_t sensor) const
+  {
+    return sensors_[sensor].name;
+  }
+  unsigned int sensorFlags(size_t sensor) const
+  {
+    return sensorFlags_[sensor];
+  }
+  /// Ticks since a value of the sensor last changed
+  int unchangedTicks(size_t sensor) const
+  {
+    return sensorUnchangedTicks_[sensor];
+  }
+
+private:
+  struct Sensor
+  {
+    std::string name;
+    size_t first;
+    size_t count;
+    bool staleCheck;
+  };
+
+  void publish(const ros::Time& time);
+
+  bool enabled_;
+  std::vector<double*> channels_;
+  std::vector<Sensor> sensors_;
+  std::vector<unsigned int> sensorFlags_;
+  std::vector<int> sensorUnchangedTicks_;
+
+  Eigen::ArrayXd values_;
+  Eigen::ArrayXd previous_;
+  Eigen::ArrayXd limits_;
+  Eigen::ArrayXi unchangedTicks_;
+  Eigen::ArrayXi flags_;
+  int staleTicks_;
+  bool reportedNonFinite_;
+
+  int publishDivider_;
+  int ticks_;
+  boost::shared_ptr<realtime_tools::RealtimePublisher<diagnostic_msgs::DiagnosticArray> >
+      publisher_;
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_SENSOR_HEALTH_H
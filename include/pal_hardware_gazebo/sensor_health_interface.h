@@ -0,0 +1,61 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_SENSOR_HEALTH_INTERFACE_H
+#define PAL_HARDWARE_GAZEBO_SENSOR_HEALTH_INTERFACE_H
+
+#include <string>
+
+#include <hardware_interface/internal/hardware_resource_manager.h>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Health flags of a joint or sensor, updated on every tick. The
+ * flags of all its values are or'ed together.
+ */
+class SensorHealthHandle
+{
+public:
+  enum Flags
+  {
+    HEALTHY = 0,
+    NON_FINITE = 1 << 0,
+    SATURATED = 1 << 1,
+    STALE = 1 << 2
+  };
+
+  SensorHealthHandle(const std::string& name = "", const unsigned int* flags = NULL)
+    : name_(name), flags_(flags)
+  {
+  }
+
+  std::string getName() const
+  {
+    return name_;
+  }
+  unsigned int getFlags() const
+  {
+    return *flags_;
+  }
+  bool isHealthy() const
+  {
+    return *flags_ == HEALTHY;
+  }
+
+private:
+  std::string name_;
+  const unsigned int* flags_;
+};
+
+class SensorHealthInterface : public hardware_interface::HardwareResourceManager<SensorHealthHandle>
+{
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_SENSOR_HEALTH_INTERFACE_H
@@ -0,0 +1,179 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_SENSOR_STREAM_RECORDER_H
+#define PAL_HARDWARE_GAZEBO_SENSOR_STREAM_RECORDER_H
+
+#include <stdint.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <pal_hardware_gazebo/buffered_signal_writer.h>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief MSB-first bit packer used by the stream compression.
+ */
+class BitWriter
+{
+public:
+  BitWriter();
+
+  void clear();
+  void write(uint64_t value, unsigned int bits);
+  /// Pads the last byte with zeros
+  void flush();
+
+  const std::vector<uint8_t>& bytes() const
+  {
+    return bytes_;
+  }
+
+private:
+  std::vector<uint8_t> bytes_;
+  uint64_t accumulator_;
+  unsigned int pending_;
+};
+
+/**
+ * @brief MSB-first bit reader matching the BitWriter.
+ */
+class BitReader
+{
+public:
+  BitReader(const uint8_t* data, size_t size);
+
+  /// Returns false, leaving value unchanged, if fewer bits are left
+  bool read(unsigned int bits, uint64_t& value);
+
+private:
+  const uint8_t* data_;
+  size_t size_;
+  size_t position_;
+};
+
+/**
+ * @brief Per signal state of the XOR compression, shared by the encoder and
+ * the decoder.
+ */
+struct XorState
+{
+  uint64_t previous;
+  unsigned int leading;
+  unsigned int trailing;
+};
+
+/**
+ * @brief Records the joint, FT and IMU streams to a compressed local file.
+ *
+ * Rows are compressed by the background thread in independent blocks, so
+ * that a truncated file is still readable up to its last complete block.
+ * Within a block the simulation time, in nanoseconds, is stored as a
+ * delta-of-delta and every signal as the XOR with its previous value, both
+ * with the variable length codes of the Gorilla time series format: an
+ * unchanged value takes a single bit and a slowly changing one only its
+ * meaningful bits.
+ *
+ * File layout, little endian:
+ *  - header: "PALREC01", uint32 signal count, then per signal a uint16 name
+ *    length followed by the name. The first signal is the time.
+ *  - blocks: uint32 row count, uint32 byte count, then the bit stream.
+ *
+ * SensorStreamReader decodes it back.
+ *
+ * Parameters, under the "sensor_recording" namespace:
+ *  - file: output path, the recording is disabled if empty
+ *  - block_rows: rows per block (default 1000)
+ *  - buffer_rows: capacity of the ring (default 10000)
+ *  - decimation: record one out of this many ticks (default 1)
+ */
+class SensorStreamRecorder : public BufferedSignalWriter
+{
+public:
+  SensorStreamRecorder();
+  ~SensorStreamRecorder();
+
+  /// Reads the configuration, returns false on errors only
+  bool configure(ros::NodeHandle& nh);
+  /// Configures without parameters, an empty file name disables the recording
+  bool configure(const std::string& file_name, size_t block_rows, size_t buffer_rows,
+                 unsigned int decimation);
+
+  bool enabled() const
+  {
+    return enabled_;
+  }
+
+  bool start();
+
+protected:
+  bool writeHeader();
+  void writeRow(const double* row);
+  void finish();
+
+private:
+  void resetBlock();
+  void flushBlock();
+  void encodeTime(int64_t time);
+  void encodeValue(double value, XorState& state);
+
+  bool enabled_;
+  std::string fileName_;
+  size_t blockRows_;
+  size_t bufferRows_;
+  unsigned int decimation_;
+
+  BitWriter bits_;
+  size_t blockFill_;
+  int64_t previousTime_;
+  int64_t previousDelta_;
+  std::vector<XorState> states_;
+
+  uint64_t rawBytes_;
+  uint64_t writtenBytes_;
+};
+
+/**
+ * @brief Reads back a file written by the SensorStreamRecorder, one block at
+ * a time. The time is restored with nanosecond resolution, the signals
+ * exactly.
+ */
+class SensorStreamReader
+{
+public:
+  bool open(const std::string& file_name);
+
+  /// Signal names, "time" first
+  const std::vector<std::string>& names() const
+  {
+    return names_;
+  }
+
+  /// Appends the rows of the next block to rows, row-major. Returns false at
+  /// the end of the file or on a truncated or corrupt block, leaving rows
+  /// unchanged.
+  bool readBlock(std::vector<double>& rows);
+
+private:
+  bool decodeTime(BitReader& bits, int64_t& time);
+  bool decodeValue(BitReader& bits, XorState& state, double& value);
+
+  std::ifstream file_;
+  std::vector<std::string> names_;
+  std::vector<uint8_t> block_;
+  std::vector<double> decoded_;
+  int64_t previousTime_;
+  int64_t previousDelta_;
+  std::vector<XorState> states_;
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_SENSOR_STREAM_RECORDER_H
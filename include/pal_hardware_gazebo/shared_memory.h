@@ -0,0 +1,70 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_SHARED_MEMORY_H
+#define PAL_HARDWARE_GAZEBO_SHARED_MEMORY_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief POSIX shared memory segment created and mapped by the simulation,
+ * and removed when it is destroyed.
+ */
+class SharedMemorySegment
+{
+public:
+  SharedMemorySegment();
+  ~SharedMemorySegment();
+
+  /// Creates, or recreates, the segment with the given name and size
+  bool create(const std::string& name, size_t size);
+  void destroy();
+
+  void* data() const
+  {
+    return data_;
+  }
+  size_t size() const
+  {
+    return size_;
+  }
+
+private:
+  SharedMemorySegment(const SharedMemorySegment&);
+  SharedMemorySegment& operator=(const SharedMemorySegment&);
+
+  std::string name_;
+  void* data_;
+  size_t size_;
+};
+
+/// Bytes taken by the names, each one followed by a null character
+size_t packedNamesSize(const std::vector<std::string>& names);
+/// Writes the names one after the other, returns the end of the written data
+char* packNames(const std::vector<std::string>& names, char* out);
+
+/// Word shared between processes that can be waited on with a futex
+typedef std::atomic<uint32_t> FutexWord;
+
+/**
+ * @brief Waits until the word differs from the given value, for at most the
+ * given time in seconds. Returns false on timeout.
+ */
+bool futexWaitWhile(FutexWord& word, uint32_t value, double timeout);
+
+/// Wakes all the processes waiting on the word
+void futexWake(FutexWord& word);
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_SHARED_MEMORY_H
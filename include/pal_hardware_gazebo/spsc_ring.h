@@ -0,0 +1,88 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_SPSC_RING_H
+#define PAL_HARDWARE_GAZEBO_SPSC_RING_H
+
+#include <atomic>
+#include <vector>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Lock-free single producer, single consumer queue of fixed width
+ * records, preallocated at init.
+ *
+ * The producer (the simulation thread) fills a slot in place and commits it,
+ * the consumer (a background thread) reads it in place and releases it. When
+ * the ring is full the producer gets no slot and must drop the record.
+ */
+template <class T>
+class SpscRing
+{
+public:
+  SpscRing() : width_(0), capacity_(0), head_(0), tail_(0)
+  {
+  }
+
+  void init(size_t width, size_t capacity)
+  {
+    width_ = width;
+    capacity_ = capacity;
+    data_.assign(width_ * capacity_, T());
+    head_.store(0);
+    tail_.store(0);
+  }
+
+  size_t width() const
+  {
+    return width_;
+  }
+
+  /// Slot to fill with the next record, NULL if the ring is full
+  T* beginWrite()
+  {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) >= capacity_)
+    {
+      return NULL;
+    }
+    return &data_[(head % capacity_) * width_];
+  }
+
+  void commitWrite()
+  {
+    head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  /// Oldest record not yet consumed, NULL if the ring is empty
+  const T* beginRead() const
+  {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire))
+    {
+      return NULL;
+    }
+    return &data_[(tail % capacity_) * width_];
+  }
+
+  void commitRead()
+  {
+    tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+private:
+  std::vector<T> data_;
+  size_t width_;
+  size_t capacity_;
+  std::atomic<size_t> head_;
+  std::atomic<size_t> tail_;
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_SPSC_RING_H
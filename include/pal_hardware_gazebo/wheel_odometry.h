@@ -0,0 +1,90 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_WHEEL_ODOMETRY_H
+#define PAL_HARDWARE_GAZEBO_WHEEL_ODOMETRY_H
+
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <ros/ros.h>
+#include <nav_msgs/Odometry.h>
+#include <realtime_tools/realtime_publisher.h>
+#include <tf2_msgs/TFMessage.h>
+
+#include <pal_hardware_gazebo/diff_drive_geometry.h>
+#include <pal_hardware_gazebo/joint_buffers.h>
+#include <pal_hardware_gazebo/odometry_interface.h>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Integrates the wheel velocities read from the simulation into a
+ * planar base pose, replacing a controller that only runs for odometry.
+ *
+ * Parameters, under the "mobile_base/odometry" namespace:
+ *  - enabled: defaults to false
+ *  - frame_id, child_frame_id: default to odom and base_footprint
+ *  - publish_divider: publish every that many ticks, 0 to not publish.
+ *    The message goes out from the realtime publisher thread.
+ *  - enable_odom_tf: also broadcast the frame_id to child_frame_id transform
+ *    on /tf, defaults to true
+ *  - pose_covariance_diagonal, twist_covariance_diagonal: the 6 diagonal
+ *    terms of the published covariances, default to zero
+ *
+ * The parameters match those of diff_drive_controller.
+ */
+class WheelOdometry
+{
+public:
+  WheelOdometry();
+
+  bool init(ros::NodeHandle& nh, const DiffDriveGeometry& geometry, const JointBuffers& joints);
+
+  bool enabled() const
+  {
+    return enabled_;
+  }
+
+  /// Integrates the wheel velocities over the period, call after reading
+  void update(const ros::Time& time, const ros::Duration& period);
+
+  OdometryHandle::Data getHandleData(const std::string& name) const;
+
+  /// Publishes factor times less often than configured, 1 to restore
+  void setPublishFactor(int factor)
+  {
+    publishFactor_ = factor;
+  }
+
+private:
+  void publish(const ros::Time& time);
+
+  bool enabled_;
+  const DiffDriveGeometry* geometry_;
+  const JointBuffers* joints_;
+
+  std::string frameId_;
+  std::string childFrameId_;
+  double x_;
+  double y_;
+  double yaw_;
+  double linear_;
+  double angular_;
+
+  int publishDivider_;
+  int publishFactor_;
+  int ticks_;
+  boost::shared_ptr<realtime_tools::RealtimePublisher<nav_msgs::Odometry> > publisher_;
+  boost::shared_ptr<realtime_tools::RealtimePublisher<tf2_msgs::TFMessage> > tfPublisher_;
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_WHEEL_ODOMETRY_H
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_WORKER_POOL_H
+#define PAL_HARDWARE_GAZEBO_WORKER_POOL_H
+
+#include <atomic>
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Fixed set of threads running the items of a batch in parallel.
+ *
+ * The items are claimed one at a time from a shared counter, so a thread
+ * that finishes early keeps taking the remaining ones. The calling thread
+ * works too, and run() only returns once every item is done.
+ */
+class WorkerPool
+{
+public:
+  typedef boost::function<void(size_t)> Task;
+
+  /// Starts the given number of threads besides the caller
+  explicit WorkerPool(size_t threads);
+  ~WorkerPool();
+
+  /// Runs task(0) ... task(count - 1), returns when all of them are done
+  void run(size_t count, const Task& task);
+
+  size_t threads() const
+  {
+    return threads_.size();
+  }
+
+private:
+  void work();
+  void drain();
+
+  boost::thread_group group_;
+  std::vector<boost::thread*> threads_;
+
+  boost::mutex mutex_;
+  boost::condition_variable wake_;
+  boost::condition_variable done_;
+  unsigned long generation_;
+  bool stop_;
+  /// Worker threads inside the current batch
+  size_t busy_;
+
+  const Task* task_;
+  size_t count_;
+  std::atomic<size_t> next_;
+  std::atomic<size_t> finished_;
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_WORKER_POOL_H
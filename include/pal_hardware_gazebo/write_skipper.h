@@ -0,0 +1,133 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#ifndef PAL_HARDWARE_GAZEBO_WRITE_SKIPPER_H
+#define PAL_HARDWARE_GAZEBO_WRITE_SKIPPER_H
+
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <dynamic_reconfigure/Config.h>
+#include <realtime_tools/realtime_buffer.h>
+#include <ros/ros.h>
+
+#include <pal_hardware_gazebo/joint_buffers.h>
+
+namespace gazebo_ros_control
+{
+/**
+ * @brief Skips the write of position and velocity controlled joints that
+ * are holding a steady command.
+ *
+ * A joint write is skipped when its command is bitwise identical to the one
+ * of its last full write, its tracking error and velocity are within the
+ * deadbands, and the e-stop state, the PID gains of its resource and the
+ * joint limits have not changed. The effort applied by the last full write is
+ * then applied again. A full write is forced after max_skipped_ticks, which
+ * bounds the drift of the PID internal state.
+ * Only joints driven through forces benefit from it, so only the joints whose
+ * resource has PID gains are skipped; the others are set kinematically.
+ * The gains are followed through the dynamic reconfigure updates of their
+ * namespace.
+ *
+ * Parameters, under the "write_skipping" namespace:
+ *  - enabled (default false)
+ *  - position_deadband (default 1e-4)
+ *  - velocity_deadband (default 1e-3)
+ *  - max_skipped_ticks (default 100)
+ *  - gains_namespace: where the resources read the PID gains of a joint
+ *    from, as <gains_namespace>/<joint> (default gazebo_ros_control/pid_gains)
+ */
+class WriteSkipper
+{
+public:
+  WriteSkipper();
+
+  bool init(ros::NodeHandle& nh, const JointBuffers& joints);
+
+  bool enabled() const
+  {
+    return enabled_;
+  }
+
+  /// Maps the active write resources, by name, to joints, call on switch.
+  /// control_methods holds the interface every joint is commanded through.
+  void setActiveResources(const std::vector<std::string>& names,
+                          const std::vector<JointBuffers::CommandType>& control_methods);
+
+  /// Applies the cached effort and returns true if the write of the given
+  /// active resource can be skipped
+  bool skip(size_t active_index, bool e_stop_active);
+
+  /// Caches the result of a full write of the given active resource
+  void written(size_t active_index, bool e_stop_active);
+
+  unsigned long skippedWrites() const
+  {
+    return skippedWrites_;
+  }
+
+private:
+  struct Gains
+  {
+    double p;
+    double i;
+    double d;
+    double iMin;
+    double iMax;
+  };
+
+  struct Limits
+  {
+    double lower;
+    double upper;
+    double velocity;
+    double effort;
+  };
+
+  struct JointCache
+  {
+    bool valid;
+    double command;
+    double effort;
+    bool eStop;
+    Gains gains;
+    Limits limits;
+    unsigned int skippedTicks;
+  };
+
+  typedef realtime_tools::RealtimeBuffer<Gains> GainsBuffer;
+
+  void gainsUpdated(const dynamic_reconfigure::ConfigConstPtr& config, size_t joint);
+  Limits limits(size_t joint) const;
+
+  bool enabled_;
+  double positionDeadband_;
+  double velocityDeadband_;
+  unsigned int maxSkippedTicks_;
+
+  struct ActiveJoint
+  {
+    /// Joint index, -1 if the resource can not be skipped
+    int joint;
+    JointBuffers::CommandType controlMethod;
+    const double* command;
+  };
+
+  const JointBuffers* joints_;
+  std::vector<JointCache> cache_;
+  /// Gains of the joints driven through forces, NULL for the others
+  std::vector<boost::shared_ptr<GainsBuffer> > gains_;
+  std::vector<ros::Subscriber> gainsSubscribers_;
+  std::vector<ActiveJoint> activeJoints_;
+  unsigned long skippedWrites_;
+};
+}
+
+#endif  // PAL_HARDWARE_GAZEBO_WRITE_SKIPPER_H
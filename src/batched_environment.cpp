@@ -0,0 +1,127 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <cmath>
+#include <map>
+
+#include <boost/bind.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <gazebo/gazebo_config.h>
+
+#include <pal_hardware_gazebo/batched_environment.h>
+
+namespace gazebo_ros_control
+{
+boost::shared_ptr<BatchedEnvironment> BatchedEnvironment::forWorld(gazebo::physics::WorldPtr world)
+{
+  static boost::mutex registry_mutex;
+  static std::map<gazebo::physics::World*, boost::weak_ptr<BatchedEnvironment> > registry;
+
+  boost::unique_lock<boost::mutex> lock(registry_mutex);
+  boost::shared_ptr<BatchedEnvironment> environment = registry[world.get()].lock();
+  if (!environment)
+  {
+    environment.reset(new BatchedEnvironment(world));
+    registry[world.get()] = environment;
+  }
+  return environment;
+}
+
+BatchedEnvironment::BatchedEnvironment(gazebo::physics::WorldPtr world)
+  : world_(world), controlPeriod_(0.), remainingIterations_(0)
+{
+  worldUpdateEnd_ = gazebo::event::Events::ConnectWorldUpdateEnd(
+      boost::bind(&BatchedEnvironment::onWorldUpdateEnd, this));
+}
+
+size_t BatchedEnvironment::addRobot(const std::string& name, size_t observation_size,
+                                    size_t action_size, const ReadCallback& read)
+{
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  Robot robot;
+  robot.name = name;
+  robot.read = read;
+  robot.observationOffset = observations_.size();
+  robot.actionOffset = actions_.size();
+  robots_.push_back(robot);
+  observations_.resize(observations_.size() + observation_size, 0.);
+  actions_.resize(actions_.size() + action_size, 0.);
+  ROS_INFO_STREAM("Robot " << name << " added to the batched environment, slot "
+                           << robots_.size() - 1);
+  return robots_.size() - 1;
+}
+
+void BatchedEnvironment::removeRobot(size_t slot)
+{
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  robots_[slot].name.clear();
+  robots_[slot].read.clear();
+}
+
+unsigned int BatchedEnvironment::iterationsPerPeriod() const
+{
+#if GAZEBO_MAJOR_VERSION >= 8
+  const double step_size = world_->Physics()->GetMaxStepSize();
+#else
+  const double step_size = world_->GetPhysicsEngine()->GetMaxStepSize();
+#endif
+  const double iterations = std::floor(controlPeriod_ / step_size + 0.5);
+  return iterations < 1. ? 1 : static_cast<unsigned int>(iterations);
+}
+
+void BatchedEnvironment::step(unsigned int control_periods)
+{
+  if (control_periods == 0)
+  {
+    return;
+  }
+  if (!world_->IsPaused())
+  {
+    ROS_WARN_STREAM_THROTTLE(1.0, "Batched step on a running world, pause it first");
+  }
+  const unsigned int iterations = control_periods * iterationsPerPeriod();
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  remainingIterations_ = iterations;
+  lock.unlock();
+
+  // World::Step only schedules the iterations, they run in the world update thread. It
+  // takes the world update lock, so it is not called with mutex_ held.
+  world_->Step(iterations);
+  lock.lock();
+  while (remainingIterations_ > 0)
+  {
+    stepDone_.wait(lock);
+  }
+}
+
+void BatchedEnvironment::onWorldUpdateEnd()
+{
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  if (remainingIterations_ == 0 || --remainingIterations_ > 0)
+  {
+    return;
+  }
+
+#if GAZEBO_MAJOR_VERSION >= 8
+  const gazebo::common::Time sim_time = world_->SimTime();
+#else
+  const gazebo::common::Time sim_time = world_->GetSimTime();
+#endif
+  const ros::Time time(sim_time.sec, sim_time.nsec);
+  for (size_t i = 0; i < robots_.size(); ++i)
+  {
+    if (robots_[i].read)
+    {
+      robots_[i].read(time);
+    }
+  }
+  stepDone_.notify_all();
+}
+}
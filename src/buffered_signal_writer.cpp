@@ -0,0 +1,135 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <stdint.h>
+
+#include <algorithm>
+
+#include <pal_hardware_gazebo/buffered_signal_writer.h>
+
+namespace gazebo_ros_control
+{
+bool readSignalNames(std::istream& in, const char* magic, std::vector<std::string>& names)
+{
+  char file_magic[8];
+  uint32_t signals = 0;
+  in.read(file_magic, sizeof(file_magic));
+  in.read(reinterpret_cast<char*>(&signals), sizeof(signals));
+  if (!in || !std::equal(file_magic, file_magic + sizeof(file_magic), magic))
+  {
+    return false;
+  }
+  names.resize(signals);
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    uint16_t length = 0;
+    in.read(reinterpret_cast<char*>(&length), sizeof(length));
+    names[i].resize(length);
+    if (length > 0)
+    {
+      in.read(&names[i][0], length);
+    }
+  }
+  return in.good();
+}
+
+BufferedSignalWriter::BufferedSignalWriter()
+  : decimation_(1), decimationFactor_(1), tick_(0), droppedRows_(0), running_(false)
+{
+  names_.push_back("time");
+  values_.push_back(NULL);
+}
+
+BufferedSignalWriter::~BufferedSignalWriter()
+{
+}
+
+void BufferedSignalWriter::addSignal(const std::string& name, const double* value)
+{
+  names_.push_back(name);
+  values_.push_back(value);
+}
+
+bool BufferedSignalWriter::start(const std::string& file_name, size_t buffer_rows,
+                                 unsigned int decimation)
+{
+  file_.open(file_name.c_str(), std::ios::binary | std::ios::trunc);
+  if (!file_ || !writeHeader() || !file_.good())
+  {
+    ROS_ERROR_STREAM("Could not write to " << file_name);
+    return false;
+  }
+
+  decimation_ = decimation;
+  tick_ = 0;
+  ring_.init(names_.size(), buffer_rows);
+
+  running_ = true;
+  writerThread_ = boost::thread(&BufferedSignalWriter::writerLoop, this);
+  ROS_INFO_STREAM("Writing " << names_.size() - 1 << " signals to " << file_name);
+  return true;
+}
+
+void BufferedSignalWriter::stop()
+{
+  if (!running_)
+  {
+    return;
+  }
+  running_ = false;
+  writerThread_.join();
+  if (droppedRows_ > 0)
+  {
+    ROS_WARN_STREAM("Dropped " << droppedRows_ << " rows, the writer could not keep up");
+  }
+}
+
+void BufferedSignalWriter::record(const ros::Time& time)
+{
+  if (++tick_ < decimation_ * decimationFactor_)
+  {
+    return;
+  }
+  tick_ = 0;
+
+  double* row = ring_.beginWrite();
+  if (!row)
+  {
+    ++droppedRows_;
+    return;
+  }
+  row[0] = time.toSec();
+  for (size_t i = 1; i < values_.size(); ++i)
+  {
+    row[i] = *values_[i];
+  }
+  ring_.commitWrite();
+}
+
+void BufferedSignalWriter::writerLoop()
+{
+  while (true)
+  {
+    // Read the flag before draining, so the rows committed before stop() are kept
+    const bool running = running_;
+    while (const double* row = ring_.beginRead())
+    {
+      writeRow(row);
+      ring_.commitRead();
+    }
+    if (!running)
+    {
+      break;
+    }
+    boost::this_thread::sleep_for(boost::chrono::milliseconds(10));
+  }
+  finish();
+  file_.close();
+}
+}
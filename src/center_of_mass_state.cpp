@@ -0,0 +1,134 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <ros/ros.h>
+#include <gazebo/gazebo_config.h>
+
+#include <pal_hardware_gazebo/center_of_mass_state.h>
+
+namespace gazebo_ros_control
+{
+CenterOfMassState::CenterOfMassState() : totalMass_(0.), mass_(0.)
+{
+  for (size_t i = 0; i < 3; ++i)
+  {
+    position_[i] = 0.;
+    velocity_[i] = 0.;
+    linearMomentum_[i] = 0.;
+    angularMomentum_[i] = 0.;
+  }
+}
+
+bool CenterOfMassState::init(gazebo::physics::ModelPtr model)
+{
+  const gazebo::physics::Link_V& links = model->GetLinks();
+  std::vector<double> masses;
+  for (size_t i = 0; i < links.size(); ++i)
+  {
+    if (!links[i]->GetInertial())
+    {
+      continue;
+    }
+#if GAZEBO_MAJOR_VERSION >= 8
+    const double mass = links[i]->GetInertial()->Mass();
+#else
+    const double mass = links[i]->GetInertial()->GetMass();
+#endif
+    if (mass > 0.)
+    {
+      links_.push_back(links[i]);
+      masses.push_back(mass);
+    }
+  }
+
+  if (links_.empty())
+  {
+    ROS_ERROR_STREAM("Model has no link with mass, cannot compute its center of mass");
+    return false;
+  }
+
+  masses_ = Eigen::Map<Eigen::VectorXd>(&masses[0], masses.size());
+  totalMass_ = masses_.sum();
+  mass_ = totalMass_;
+  positions_.setZero(3, links_.size());
+  velocities_.setZero(3, links_.size());
+  angularVelocities_.setZero(3, links_.size());
+  worldInertias_.resize(links_.size());
+  return true;
+}
+
+void CenterOfMassState::update()
+{
+  for (size_t i = 0; i < links_.size(); ++i)
+  {
+    const gazebo::physics::LinkPtr& link = links_[i];
+#if GAZEBO_MAJOR_VERSION >= 8
+    const ignition::math::Vector3d p = link->WorldCoGPose().Pos();
+    const ignition::math::Vector3d v = link->WorldCoGLinearVel();
+    const ignition::math::Vector3d w = link->WorldAngularVel();
+    const ignition::math::Matrix3d I = link->WorldInertiaMatrix();
+    positions_.col(i) << p.X(), p.Y(), p.Z();
+    velocities_.col(i) << v.X(), v.Y(), v.Z();
+    angularVelocities_.col(i) << w.X(), w.Y(), w.Z();
+    for (int r = 0; r < 3; ++r)
+    {
+      for (int c = 0; c < 3; ++c)
+      {
+        worldInertias_[i](r, c) = I(r, c);
+      }
+    }
+#else
+    const gazebo::math::Vector3 p = link->GetWorldCoGPose().pos;
+    const gazebo::math::Vector3 v = link->GetWorldCoGLinearVel();
+    const gazebo::math::Vector3 w = link->GetWorldAngularVel();
+    const gazebo::math::Matrix3 I = link->GetWorldInertiaMatrix();
+    positions_.col(i) << p.x, p.y, p.z;
+    velocities_.col(i) << v.x, v.y, v.z;
+    angularVelocities_.col(i) << w.x, w.y, w.z;
+    for (int r = 0; r < 3; ++r)
+    {
+      for (int c = 0; c < 3; ++c)
+      {
+        worldInertias_[i](r, c) = I[r][c];
+      }
+    }
+#endif
+  }
+
+  const Eigen::Vector3d linear_momentum = velocities_ * masses_;
+  const Eigen::Vector3d com = positions_ * masses_ / totalMass_;
+  const Eigen::Vector3d com_velocity = linear_momentum / totalMass_;
+
+  Eigen::Vector3d angular_momentum = Eigen::Vector3d::Zero();
+  for (size_t i = 0; i < links_.size(); ++i)
+  {
+    const Eigen::Vector3d r = positions_.col(i) - com;
+    angular_momentum += r.cross(masses_(i) * velocities_.col(i)) +
+                        worldInertias_[i] * angularVelocities_.col(i);
+  }
+
+  Eigen::Vector3d::Map(position_) = com;
+  Eigen::Vector3d::Map(velocity_) = com_velocity;
+  Eigen::Vector3d::Map(linearMomentum_) = linear_momentum;
+  Eigen::Vector3d::Map(angularMomentum_) = angular_momentum;
+}
+
+CenterOfMassHandle::Data CenterOfMassState::getHandleData(const std::string& name) const
+{
+  CenterOfMassHandle::Data data;
+  data.name = name;
+  data.frame_id = "world";
+  data.mass = &mass_;
+  data.position = position_;
+  data.velocity = velocity_;
+  data.linear_momentum = linearMomentum_;
+  data.angular_momentum = angularMomentum_;
+  return data;
+}
+}
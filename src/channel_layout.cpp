@@ -0,0 +1,37 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <algorithm>
+
+#include <ros/ros.h>
+
+#include <pal_hardware_gazebo/channel_layout.h>
+
+namespace gazebo_ros_control
+{
+bool ChannelLayout::init(const std::vector<std::string>& wanted,
+                         const std::vector<std::string>& names,
+                         const std::vector<double*>& channels)
+{
+  names_.clear();
+  channels_.clear();
+  for (size_t i = 0; i < wanted.size(); ++i)
+  {
+    std::vector<std::string>::const_iterator it = std::find(names.begin(), names.end(), wanted[i]);
+    if (it == names.end())
+    {
+      ROS_ERROR_STREAM("Unknown channel " << wanted[i]);
+      return false;
+    }
+    names_.push_back(wanted[i]);
+    channels_.push_back(channels[it - names.begin()]);
+  }
+  return true;
+}
+}
@@ -0,0 +1,192 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <algorithm>
+#include <ctime>
+
+#include <sched.h>
+
+#include <pal_hardware_gazebo/co_simulation.h>
+
+namespace gazebo_ros_control
+{
+namespace
+{
+uint64_t monotonicNs()
+{
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+}
+
+inline void cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#endif
+}
+}
+
+CoSimulation::CoSimulation()
+  : enabled_(false)
+  , timeout_(0.)
+  , holdOnTimeout_(false)
+  , header_(NULL)
+  , outputs_(NULL)
+  , inputs_(NULL)
+  , tick_(0)
+  , pending_(false)
+  , lastRoundTrip_(0.)
+  , maxRoundTrip_(0.)
+  , timeouts_(0)
+{
+}
+
+bool CoSimulation::init(ros::NodeHandle& nh, const std::string& default_name,
+                        const std::vector<std::string>& channel_names,
+                        const std::vector<double*>& channels,
+                        const std::vector<std::string>& writable_names,
+                        const std::vector<double*>& writable)
+{
+  ros::NodeHandle cosim_nh(nh, "co_simulation");
+  cosim_nh.param("enabled", enabled_, false);
+  if (!enabled_)
+  {
+    return true;
+  }
+
+  std::string name, on_timeout;
+  std::vector<std::string> output_names, input_names;
+  cosim_nh.param("name", name, default_name);
+  cosim_nh.param("timeout", timeout_, 0.01);
+  cosim_nh.param<std::string>("on_timeout", on_timeout, "proceed");
+  cosim_nh.getParam("outputs", output_names);
+  cosim_nh.getParam("inputs", input_names);
+  if (timeout_ <= 0.)
+  {
+    ROS_ERROR_STREAM("co_simulation/timeout must be positive");
+    return false;
+  }
+  if (on_timeout != "proceed" && on_timeout != "hold")
+  {
+    ROS_ERROR_STREAM("co_simulation/on_timeout must be proceed or hold, not " << on_timeout);
+    return false;
+  }
+  holdOnTimeout_ = on_timeout == "hold";
+  if (!outputLayout_.init(output_names, channel_names, channels) ||
+      !inputLayout_.init(input_names, writable_names, writable))
+  {
+    return false;
+  }
+
+  const size_t names_size = packedNamesSize(output_names) + packedNamesSize(input_names);
+  const size_t names_offset = sizeof(CoSimulationHeader) +
+                              (output_names.size() + input_names.size()) * sizeof(double);
+  if (!segment_.create(name, names_offset + names_size))
+  {
+    return false;
+  }
+
+  char* base = static_cast<char*>(segment_.data());
+  header_ = reinterpret_cast<CoSimulationHeader*>(base);
+  outputs_ = reinterpret_cast<double*>(base + sizeof(CoSimulationHeader));
+  inputs_ = outputs_ + output_names.size();
+  packNames(input_names, packNames(output_names, base + names_offset));
+  inputLayout_.gather(inputs_);
+
+  header_->output_size = output_names.size();
+  header_->input_size = input_names.size();
+  header_->names_offset = names_offset;
+  header_->names_size = names_size;
+  header_->tick.store(0);
+  header_->ack.store(0);
+  header_->missed.store(0);
+  header_->version = CoSimulationHeader::VERSION;
+  std::atomic_thread_fence(std::memory_order_release);
+  header_->magic = CoSimulationHeader::MAGIC;
+
+  ROS_INFO_STREAM("Co-simulation block " << name << " with " << output_names.size()
+                                         << " outputs and " << input_names.size() << " inputs");
+  return true;
+}
+
+void CoSimulation::notify(const ros::Time& time, const ros::Duration& period)
+{
+  // Odd while writing, so that a late partner still reading the previous outputs retries
+  header_->tick.store(tick_ + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  outputLayout_.gather(outputs_);
+  header_->time = time.toSec();
+  header_->period = period.toSec();
+  header_->notify_time_ns = monotonicNs();
+  tick_ += 2;
+  header_->tick.store(tick_, std::memory_order_release);
+  pending_ = true;
+}
+
+bool CoSimulation::acknowledge()
+{
+  if (!pending_)
+  {
+    return false;
+  }
+  pending_ = false;
+
+  const uint64_t timeout_ns = static_cast<uint64_t>(timeout_ * 1e9);
+  if (!waitForPartner(header_->notify_time_ns + timeout_ns))
+  {
+    ++timeouts_;
+    header_->missed.store(timeouts_, std::memory_order_release);
+    ROS_WARN_STREAM_THROTTLE(1.0, "Co-simulation partner missed its deadline, "
+                                      << timeouts_ << " ticks missed so far"
+                                      << (holdOnTimeout_ ? ", holding" : ""));
+    if (!holdOnTimeout_)
+    {
+      return false;
+    }
+    while (!waitForPartner(monotonicNs() + timeout_ns))
+    {
+      ROS_WARN_STREAM_THROTTLE(1.0, "Still holding for the co-simulation partner");
+    }
+  }
+
+  // Partners that do not stamp their answer get the time it was seen
+  const uint64_t ack_time = header_->ack_time_ns >= header_->notify_time_ns ?
+                                header_->ack_time_ns :
+                                monotonicNs();
+  lastRoundTrip_ = (ack_time - header_->notify_time_ns) * 1e-9;
+  maxRoundTrip_ = std::max(maxRoundTrip_, lastRoundTrip_);
+  inputLayout_.scatter(inputs_);
+  return true;
+}
+
+bool CoSimulation::waitForPartner(uint64_t deadline)
+{
+  if (header_->ack.load(std::memory_order_acquire) == tick_)
+  {
+    return true;
+  }
+  unsigned int spins = 0;
+  while (header_->ack.load(std::memory_order_acquire) != tick_)
+  {
+    cpuRelax();
+    // Reading the clock costs more than a spin, check it now and then, and
+    // give the partner a chance to run if it shares the core
+    if (++spins % 64 == 0)
+    {
+      if (monotonicNs() > deadline)
+      {
+        return false;
+      }
+      sched_yield();
+    }
+  }
+  return true;
+}
+}
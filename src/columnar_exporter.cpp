@@ -0,0 +1,150 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <stdint.h>
+
+#include <pal_hardware_gazebo/columnar_exporter.h>
+
+namespace gazebo_ros_control
+{
+ColumnarExporter::ColumnarExporter()
+  : enabled_(false), chunkRows_(1000), bufferRows_(10000), decimation_(1), chunkFill_(0)
+{
+}
+
+ColumnarExporter::~ColumnarExporter()
+{
+  stop();
+}
+
+bool ColumnarExporter::configure(ros::NodeHandle& nh)
+{
+  ros::NodeHandle export_nh(nh, "introspection_export");
+  export_nh.param("file", fileName_, std::string());
+  enabled_ = !fileName_.empty();
+  if (!enabled_)
+  {
+    return true;
+  }
+
+  int chunk_rows, buffer_rows, decimation;
+  export_nh.param("chunk_rows", chunk_rows, 1000);
+  export_nh.param("buffer_rows", buffer_rows, 10000);
+  export_nh.param("decimation", decimation, 1);
+  if (chunk_rows <= 0 || buffer_rows <= 0 || decimation <= 0)
+  {
+    ROS_ERROR_STREAM("Introspection export sizes and decimation must be positive");
+    enabled_ = false;
+    return false;
+  }
+  return configure(fileName_, chunk_rows, buffer_rows, decimation);
+}
+
+bool ColumnarExporter::configure(const std::string& file_name, size_t chunk_rows,
+                                 size_t buffer_rows, unsigned int decimation)
+{
+  fileName_ = file_name;
+  enabled_ = !fileName_.empty() && chunk_rows > 0 && buffer_rows > 0 && decimation > 0;
+  chunkRows_ = chunk_rows;
+  bufferRows_ = buffer_rows;
+  decimation_ = decimation;
+  return true;
+}
+
+bool ColumnarExporter::start()
+{
+  chunk_.resize(names_.size() * chunkRows_);
+  chunkFill_ = 0;
+  enabled_ = BufferedSignalWriter::start(fileName_, bufferRows_, decimation_);
+  return enabled_;
+}
+
+bool ColumnarExporter::writeHeader()
+{
+  const char magic[8] = { 'P', 'A', 'L', 'C', 'O', 'L', '0', '1' };
+  file_.write(magic, sizeof(magic));
+  const uint32_t columns = names_.size();
+  file_.write(reinterpret_cast<const char*>(&columns), sizeof(columns));
+  for (size_t i = 0; i < names_.size(); ++i)
+  {
+    const uint16_t length = names_[i].size();
+    file_.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    file_.write(names_[i].data(), length);
+  }
+  return file_.good();
+}
+
+void ColumnarExporter::writeRow(const double* row)
+{
+  for (size_t c = 0; c < names_.size(); ++c)
+  {
+    chunk_[c * chunkRows_ + chunkFill_] = row[c];
+  }
+  if (++chunkFill_ == chunkRows_)
+  {
+    flushChunk();
+  }
+}
+
+void ColumnarExporter::finish()
+{
+  flushChunk();
+}
+
+void ColumnarExporter::flushChunk()
+{
+  if (chunkFill_ == 0)
+  {
+    return;
+  }
+  const uint32_t rows = chunkFill_;
+  file_.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+  for (size_t c = 0; c < names_.size(); ++c)
+  {
+    file_.write(reinterpret_cast<const char*>(&chunk_[c * chunkRows_]), rows * sizeof(double));
+  }
+  file_.flush();
+  chunkFill_ = 0;
+}
+
+bool ColumnarReader::open(const std::string& file_name)
+{
+  const char magic[8] = { 'P', 'A', 'L', 'C', 'O', 'L', '0', '1' };
+  file_.open(file_name.c_str(), std::ios::binary);
+  return file_ && readSignalNames(file_, magic, names_) && !names_.empty();
+}
+
+bool ColumnarReader::readChunk(std::vector<double>& rows)
+{
+  uint32_t count = 0;
+  file_.read(reinterpret_cast<char*>(&count), sizeof(count));
+  if (!file_ || count == 0)
+  {
+    return false;
+  }
+  chunk_.resize(static_cast<size_t>(count) * names_.size());
+  file_.read(reinterpret_cast<char*>(&chunk_[0]), chunk_.size() * sizeof(double));
+  if (!file_)
+  {
+    return false;
+  }
+
+  const size_t columns = names_.size();
+  const size_t first = rows.size();
+  rows.resize(first + chunk_.size());
+  for (size_t c = 0; c < columns; ++c)
+  {
+    for (size_t r = 0; r < count; ++r)
+    {
+      rows[first + r * columns + c] = chunk_[c * count + r];
+    }
+  }
+  return true;
+}
+}
@@ -0,0 +1,221 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <algorithm>
+
+#include <pal_hardware_gazebo/controller_claims.h>
+
+namespace gazebo_ros_control
+{
+namespace
+{
+typedef std::vector<hardware_interface::InterfaceResources> InterfaceResourcesList;
+
+void removeAll(const std::vector<std::string>& names, std::vector<std::string>& from)
+{
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    std::vector<std::string>::iterator it = std::find(from.begin(), from.end(), names[i]);
+    if (it != from.end())
+    {
+      from.erase(it);
+    }
+  }
+}
+}
+
+ControllerClaims::ControllerClaims() : joints_(NULL)
+{
+}
+
+void ControllerClaims::init(const JointBuffers& joints)
+{
+  joints_ = &joints;
+  cache_.clear();
+  pending_.clear();
+  groupNames_.clear();
+  groupIndex_.build(groupNames_);
+  groupJoints_.clear();
+  reserved_ = ResourceBitset(joints.size());
+  active_ = ResourceBitset(joints.size());
+  activeGroups_ = ResourceBitset();
+  activeOthers_.clear();
+}
+
+size_t ControllerClaims::addGroup(const std::string& name, const std::vector<size_t>& joint_indices)
+{
+  ResourceBitset joints(joints_->size());
+  for (size_t i = 0; i < joint_indices.size(); ++i)
+  {
+    joints.set(joint_indices[i]);
+  }
+  const size_t index = groupJoints_.size();
+  groupNames_.push_back(name);
+  groupIndex_.build(groupNames_);
+  groupJoints_.push_back(joints);
+  activeGroups_ = ResourceBitset(groupJoints_.size());
+  return index;
+}
+
+void ControllerClaims::reserve(const hardware_interface::ControllerInfo& owner)
+{
+  Claims claims;
+  build(owner, claims);
+  reserved_ |= claims.joints;
+}
+
+const ControllerClaims::Claims* ControllerClaims::cached(const std::string& name) const
+{
+  std::map<std::string, Claims>::const_iterator it = cache_.find(name);
+  if (it != cache_.end())
+  {
+    return &it->second;
+  }
+  it = pending_.find(name);
+  return it != pending_.end() ? &it->second : NULL;
+}
+
+void ControllerClaims::build(const hardware_interface::ControllerInfo& info, Claims& claims) const
+{
+  claims.joints = ResourceBitset(joints_->size());
+  claims.groups = ResourceBitset(groupJoints_.size());
+  claims.others.clear();
+  for (InterfaceResourcesList::const_iterator it = info.claimed_resources.begin();
+       it != info.claimed_resources.end(); ++it)
+  {
+    for (std::set<std::string>::const_iterator res = it->resources.begin();
+         res != it->resources.end(); ++res)
+    {
+      const int index = joints_->index(*res);
+      const int group = index < 0 ? groupIndex_.find(*res) : -1;
+      if (index >= 0)
+      {
+        claims.joints.set(index);
+      }
+      else if (group >= 0)
+      {
+        claims.groups.set(group);
+        claims.joints |= groupJoints_[group];
+      }
+      else
+      {
+        claims.others.push_back(*res);
+      }
+    }
+  }
+}
+
+bool ControllerClaims::accumulate(const Claims& claims, ResourceBitset& joints,
+                                  std::vector<std::string>& others, std::string& resource) const
+{
+  const size_t common = joints.firstCommon(claims.joints);
+  if (common < joints.size())
+  {
+    resource = joints_->names[common];
+    return true;
+  }
+  joints |= claims.joints;
+
+  for (size_t i = 0; i < claims.others.size(); ++i)
+  {
+    if (std::find(others.begin(), others.end(), claims.others[i]) != others.end())
+    {
+      resource = claims.others[i];
+      return true;
+    }
+    others.push_back(claims.others[i]);
+  }
+  return false;
+}
+
+bool ControllerClaims::findConflict(const ControllerList& controllers, std::string& resource) const
+{
+  // Also called for loaded controllers that are not running, whose claims are not cached
+  ResourceBitset joints = reserved_;
+  std::vector<std::string> others;
+  Claims claims;
+  for (ControllerList::const_iterator it = controllers.begin(); it != controllers.end(); ++it)
+  {
+    const Claims* known = cached(it->name);
+    if (!known)
+    {
+      build(*it, claims);
+      known = &claims;
+    }
+    if (accumulate(*known, joints, others, resource))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ControllerClaims::findSwitchConflict(const ControllerList& start_list,
+                                          const ControllerList& stop_list,
+                                          std::string& resource) const
+{
+  pending_.clear();
+  ResourceBitset joints = active_;
+  joints |= reserved_;
+  std::vector<std::string> others = activeOthers_;
+  for (ControllerList::const_iterator it = stop_list.begin(); it != stop_list.end(); ++it)
+  {
+    const Claims* stopped = cached(it->name);
+    if (stopped)
+    {
+      joints.subtract(stopped->joints);
+      removeAll(stopped->others, others);
+    }
+  }
+  for (ControllerList::const_iterator it = start_list.begin(); it != start_list.end(); ++it)
+  {
+    Claims& started = pending_[it->name];
+    build(*it, started);
+    if (accumulate(started, joints, others, resource))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ControllerClaims::doSwitch(const ControllerList& start_list, const ControllerList& stop_list)
+{
+  for (ControllerList::const_iterator it = stop_list.begin(); it != stop_list.end(); ++it)
+  {
+    std::map<std::string, Claims>::iterator stopped = cache_.find(it->name);
+    if (stopped == cache_.end())
+    {
+      continue;
+    }
+    active_.subtract(stopped->second.joints);
+    activeGroups_.subtract(stopped->second.groups);
+    removeAll(stopped->second.others, activeOthers_);
+    // A controller reloaded under the same name is built again when started
+    cache_.erase(stopped);
+  }
+  for (ControllerList::const_iterator it = start_list.begin(); it != start_list.end(); ++it)
+  {
+    Claims& started = cache_[it->name];
+    std::map<std::string, Claims>::iterator prepared = pending_.find(it->name);
+    if (prepared != pending_.end())
+    {
+      started = prepared->second;
+    }
+    else
+    {
+      build(*it, started);
+    }
+    active_ |= started.joints;
+    activeGroups_ |= started.groups;
+    activeOthers_.insert(activeOthers_.end(), started.others.begin(), started.others.end());
+  }
+  pending_.clear();
+}
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <pal_hardware_gazebo/controller_host.h>
+
+namespace gazebo_ros_control
+{
+ControllerHost::ControllerHost()
+  : enabled_(false)
+  , timeout_(0.)
+  , header_(NULL)
+  , state_(NULL)
+  , commands_(NULL)
+  , seq_(0)
+  , timeouts_(0)
+{
+}
+
+bool ControllerHost::init(ros::NodeHandle& nh, const std::string& default_name,
+                          const std::vector<double*>& state,
+                          const std::vector<std::string>& state_names,
+                          const std::vector<double*>& commands,
+                          const std::vector<std::string>& command_names)
+{
+  ros::NodeHandle host_nh(nh, "controller_host");
+  host_nh.param("enabled", enabled_, false);
+  if (!enabled_)
+  {
+    return true;
+  }
+
+  std::string name;
+  host_nh.param("name", name, default_name);
+  host_nh.param("timeout", timeout_, 0.01);
+  if (timeout_ <= 0.)
+  {
+    ROS_ERROR_STREAM("controller_host/timeout must be positive");
+    return false;
+  }
+
+  const size_t names_offset = sizeof(ControllerMailboxHeader) +
+                              (state.size() + commands.size()) * sizeof(double);
+  const size_t names_size = packedNamesSize(state_names) + packedNamesSize(command_names);
+  if (!segment_.create(name, names_offset + names_size))
+  {
+    return false;
+  }
+
+  char* base = static_cast<char*>(segment_.data());
+  header_ = reinterpret_cast<ControllerMailboxHeader*>(base);
+  state_ = reinterpret_cast<double*>(base + sizeof(ControllerMailboxHeader));
+  commands_ = state_ + state.size();
+  packNames(command_names, packNames(state_names, base + names_offset));
+
+  stateSources_ = state;
+  commandTargets_ = commands;
+  for (size_t i = 0; i < commands.size(); ++i)
+  {
+    commands_[i] = *commands[i];
+  }
+
+  header_->state_size = state.size();
+  header_->command_size = commands.size();
+  header_->names_offset = names_offset;
+  header_->names_size = names_size;
+  header_->state_seq.store(0);
+  header_->command_seq.store(0);
+  header_->version = ControllerMailboxHeader::VERSION;
+  std::atomic_thread_fence(std::memory_order_release);
+  header_->magic = ControllerMailboxHeader::MAGIC;
+
+  ROS_INFO_STREAM("Controller host mailbox " << name << " with " << state.size()
+                                             << " state and " << commands.size()
+                                             << " command channels");
+  return true;
+}
+
+void ControllerHost::publishState(const ros::Time& time, const ros::Duration& period)
+{
+  // Odd while writing, so that readers of the previous state retry
+  header_->state_seq.store(seq_ + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  for (size_t i = 0; i < stateSources_.size(); ++i)
+  {
+    state_[i] = *stateSources_[i];
+  }
+  header_->time = time.toSec();
+  header_->period = period.toSec();
+  seq_ += 2;
+  header_->state_seq.store(seq_, std::memory_order_release);
+  futexWake(header_->state_seq);
+}
+
+bool ControllerHost::receiveCommands()
+{
+  uint32_t answered = header_->command_seq.load(std::memory_order_acquire);
+  while (answered != seq_)
+  {
+    if (!futexWaitWhile(header_->command_seq, answered, timeout_))
+    {
+      ++timeouts_;
+      ROS_WARN_STREAM_THROTTLE(1.0, "Controller process missed its deadline, "
+                                        << timeouts_ << " ticks missed so far");
+      return false;
+    }
+    answered = header_->command_seq.load(std::memory_order_acquire);
+  }
+
+  for (size_t i = 0; i < commandTargets_.size(); ++i)
+  {
+    *commandTargets_[i] = commands_[i];
+  }
+  return true;
+}
+}
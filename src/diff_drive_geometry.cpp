@@ -0,0 +1,72 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <pal_hardware_gazebo/diff_drive_geometry.h>
+
+namespace gazebo_ros_control
+{
+namespace
+{
+bool parseWheels(ros::NodeHandle& nh, const std::string& param, const JointBuffers& joints,
+                 std::vector<size_t>& wheels)
+{
+  std::vector<std::string> names;
+  if (!nh.getParam(param, names) || names.empty())
+  {
+    ROS_ERROR_STREAM("Mobile base needs at least one joint in " << param);
+    return false;
+  }
+  wheels.clear();
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    const int index = joints.index(names[i]);
+    if (index < 0)
+    {
+      ROS_ERROR_STREAM("Unknown wheel joint " << names[i]);
+      return false;
+    }
+    wheels.push_back(index);
+  }
+  return true;
+}
+}
+
+DiffDriveGeometry::DiffDriveGeometry() : wheelRadius(0.), wheelSeparation(0.)
+{
+}
+
+bool DiffDriveGeometry::init(ros::NodeHandle& nh, const JointBuffers& joints)
+{
+  ros::NodeHandle base_nh(nh, "mobile_base");
+  if (!parseWheels(base_nh, "left_wheels", joints, leftWheels) ||
+      !parseWheels(base_nh, "right_wheels", joints, rightWheels))
+  {
+    return false;
+  }
+  if (!base_nh.getParam("wheel_radius", wheelRadius) ||
+      !base_nh.getParam("wheel_separation", wheelSeparation) || wheelRadius <= 0. ||
+      wheelSeparation <= 0.)
+  {
+    ROS_ERROR_STREAM("Mobile base needs a positive wheel_radius and wheel_separation");
+    return false;
+  }
+  return true;
+}
+
+double DiffDriveGeometry::mean(const std::vector<size_t>& wheels,
+                               const std::vector<double*>& values)
+{
+  double sum = 0.;
+  for (size_t i = 0; i < wheels.size(); ++i)
+  {
+    sum += *values[wheels[i]];
+  }
+  return sum / wheels.size();
+}
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <algorithm>
+
+#include <gazebo/gazebo_config.h>
+
+#include <pal_hardware_gazebo/floating_base_state.h>
+
+namespace gazebo_ros_control
+{
+FloatingBaseState::FloatingBaseState()
+{
+  std::fill(state_, state_ + SIZE, 0.);
+}
+
+void FloatingBaseState::init(gazebo::physics::ModelPtr model)
+{
+  model_ = model;
+}
+
+void FloatingBaseState::addChannels(std::vector<std::string>& names,
+                                    std::vector<double*>& channels)
+{
+  const char* suffixes[SIZE] = {
+    "position_x",        "position_y",        "position_z",         "orientation_x",
+    "orientation_y",     "orientation_z",     "orientation_w",      "linear_velocity_x",
+    "linear_velocity_y", "linear_velocity_z", "angular_velocity_x", "angular_velocity_y",
+    "angular_velocity_z"
+  };
+  for (size_t i = 0; i < SIZE; ++i)
+  {
+    names.push_back(std::string("base/") + suffixes[i]);
+    channels.push_back(&state_[i]);
+  }
+}
+
+bool FloatingBaseState::uses(const std::vector<std::string>& names)
+{
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    if (names[i].compare(0, 5, "base/") == 0)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+void FloatingBaseState::update()
+{
+#if GAZEBO_MAJOR_VERSION >= 8
+  const ignition::math::Pose3d pose = model_->WorldPose();
+  const ignition::math::Vector3d linear = model_->WorldLinearVel();
+  const ignition::math::Vector3d angular = model_->WorldAngularVel();
+  const double values[SIZE] = { pose.Pos().X(), pose.Pos().Y(), pose.Pos().Z(),
+                                pose.Rot().X(), pose.Rot().Y(), pose.Rot().Z(),
+                                pose.Rot().W(), linear.X(),     linear.Y(),
+                                linear.Z(),     angular.X(),    angular.Y(),
+                                angular.Z() };
+#else
+  const gazebo::math::Pose pose = model_->GetWorldPose();
+  const gazebo::math::Vector3 linear = model_->GetWorldLinearVel();
+  const gazebo::math::Vector3 angular = model_->GetWorldAngularVel();
+  const double values[SIZE] = { pose.pos.x, pose.pos.y, pose.pos.z, pose.rot.x, pose.rot.y,
+                                pose.rot.z, pose.rot.w, linear.x,   linear.y,   linear.z,
+                                angular.x,  angular.y,  angular.z };
+#endif
+  std::copy(values, values + SIZE, state_);
+}
+}
@@ -0,0 +1,275 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <cmath>
+
+#include <gazebo/gazebo_config.h>
+
+#include <pal_hardware_gazebo/grasp_manager.h>
+
+namespace gazebo_ros_control
+{
+bool GraspManager::init(ros::NodeHandle& nh, const std::vector<std::string>& gripper_names,
+                        const JointBuffers& joints, gazebo::physics::ModelPtr model)
+{
+  model_ = model;
+  joints_ = &joints;
+  contactManager_ = NULL;
+  if (gripper_names.empty())
+  {
+    return true;
+  }
+
+  ros::NodeHandle grasping_nh(nh, "grasping");
+  std::vector<std::string> collisions;
+  for (size_t i = 0; i < gripper_names.size(); ++i)
+  {
+    Gripper gripper;
+    gripper.name = gripper_names[i];
+    ros::NodeHandle gripper_nh(grasping_nh, gripper.name);
+
+    std::string palm_link;
+    std::vector<std::string> finger_links, finger_joints;
+    if (!gripper_nh.getParam("palm_link", palm_link) ||
+        !gripper_nh.getParam("finger_links", finger_links) ||
+        !gripper_nh.getParam("finger_joints", finger_joints))
+    {
+      ROS_ERROR_STREAM("Gripper " << gripper.name
+                                  << " needs palm_link, finger_links and finger_joints");
+      return false;
+    }
+    gripper.palm = model->GetLink(palm_link);
+    if (!gripper.palm)
+    {
+      ROS_ERROR_STREAM("Could not find palm link '" << palm_link << "' of gripper "
+                                                    << gripper.name);
+      return false;
+    }
+    for (size_t j = 0; j < finger_links.size(); ++j)
+    {
+      gazebo::physics::LinkPtr link = model->GetLink(finger_links[j]);
+      if (!link)
+      {
+        ROS_ERROR_STREAM("Could not find finger link '" << finger_links[j] << "' of gripper "
+                                                        << gripper.name);
+        return false;
+      }
+      gripper.fingerLinks.push_back(link);
+      const gazebo::physics::Collision_V link_collisions = link->GetCollisions();
+      for (size_t k = 0; k < link_collisions.size(); ++k)
+      {
+        collisions.push_back(link_collisions[k]->GetScopedName());
+      }
+    }
+    for (size_t j = 0; j < finger_joints.size(); ++j)
+    {
+      const int index = joints.index(finger_joints[j]);
+      if (index < 0)
+      {
+        ROS_ERROR_STREAM("Unknown finger joint '" << finger_joints[j] << "' of gripper "
+                                                  << gripper.name);
+        return false;
+      }
+      gripper.fingerJoints.push_back(index);
+    }
+
+    gripper_nh.param("min_fingers", gripper.minFingers, 2);
+    gripper_nh.param("stall_velocity", gripper.stallVelocity, 0.01);
+    gripper_nh.param("stable_ticks", gripper.stableTicks, 10);
+    gripper_nh.param("release_tolerance", gripper.releaseTolerance, 0.005);
+    gripper_nh.param("open_direction", gripper.openDirection, 1.);
+    if (gripper.minFingers < 1 || gripper.minFingers > static_cast<int>(finger_links.size()) ||
+        gripper.fingerJoints.empty() || std::fabs(gripper.openDirection) != 1.)
+    {
+      ROS_ERROR_STREAM("Invalid finger configuration or open direction of gripper "
+                       << gripper.name);
+      return false;
+    }
+
+    gripper.touched.resize(gripper.fingerLinks.size());
+    gripper.graspPositions.resize(gripper.fingerJoints.size());
+    gripper.heldTicks = 0;
+    grippers_.push_back(gripper);
+    ROS_INFO_STREAM("Parsed gripper: " << gripper.name);
+  }
+
+#if GAZEBO_MAJOR_VERSION >= 8
+  contactManager_ = model->GetWorld()->Physics()->GetContactManager();
+#else
+  contactManager_ = model->GetWorld()->GetPhysicsEngine()->GetContactManager();
+#endif
+  // Contacts are only recorded for the collisions someone listens to
+  contactManager_->CreateFilter(model->GetName() + "_grasping", collisions);
+  return true;
+}
+
+std::vector<size_t> GraspManager::fingerJoints() const
+{
+  std::vector<size_t> indices;
+  for (size_t i = 0; i < grippers_.size(); ++i)
+  {
+    indices.insert(indices.end(), grippers_[i].fingerJoints.begin(),
+                   grippers_[i].fingerJoints.end());
+  }
+  return indices;
+}
+
+void GraspManager::update()
+{
+  collectContacts();
+  for (size_t i = 0; i < grippers_.size(); ++i)
+  {
+    Gripper& gripper = grippers_[i];
+    if (gripper.attachment)
+    {
+      if (opened(gripper))
+      {
+        detach(gripper);
+      }
+      continue;
+    }
+
+    gazebo::physics::LinkPtr object = graspedObject(gripper);
+    if (!object || object != gripper.candidate || !stalled(gripper))
+    {
+      gripper.candidate = object;
+      gripper.heldTicks = 0;
+      continue;
+    }
+    if (++gripper.heldTicks >= gripper.stableTicks)
+    {
+      attach(gripper, object);
+    }
+  }
+}
+
+void GraspManager::collectContacts()
+{
+  for (size_t i = 0; i < grippers_.size(); ++i)
+  {
+    for (size_t j = 0; j < grippers_[i].touched.size(); ++j)
+    {
+      grippers_[i].touched[j].reset();
+    }
+  }
+
+  const std::vector<gazebo::physics::Contact*>& contacts = contactManager_->GetContacts();
+  const unsigned int count = contactManager_->GetContactCount();
+  for (unsigned int c = 0; c < count; ++c)
+  {
+    gazebo::physics::LinkPtr first = contacts[c]->collision1->GetLink();
+    gazebo::physics::LinkPtr second = contacts[c]->collision2->GetLink();
+    const bool first_ours = first->GetModel() == model_;
+    const bool second_ours = second->GetModel() == model_;
+    if (first_ours == second_ours)
+    {
+      continue;
+    }
+    const gazebo::physics::LinkPtr& finger = first_ours ? first : second;
+    const gazebo::physics::LinkPtr& object = first_ours ? second : first;
+
+    for (size_t i = 0; i < grippers_.size(); ++i)
+    {
+      Gripper& gripper = grippers_[i];
+      for (size_t j = 0; j < gripper.fingerLinks.size(); ++j)
+      {
+        if (gripper.fingerLinks[j] == finger)
+        {
+          gripper.touched[j] = object;
+        }
+      }
+    }
+  }
+}
+
+gazebo::physics::LinkPtr GraspManager::graspedObject(const Gripper& gripper) const
+{
+  for (size_t i = 0; i < gripper.touched.size(); ++i)
+  {
+    // Static models, like the table under the object, can not be picked up
+    if (!gripper.touched[i] || gripper.touched[i]->GetModel()->IsStatic())
+    {
+      continue;
+    }
+    int fingers = 0;
+    for (size_t j = i; j < gripper.touched.size(); ++j)
+    {
+      fingers += gripper.touched[j] == gripper.touched[i];
+    }
+    if (fingers >= gripper.minFingers)
+    {
+      return gripper.touched[i];
+    }
+  }
+  return gazebo::physics::LinkPtr();
+}
+
+bool GraspManager::stalled(const Gripper& gripper) const
+{
+  for (size_t i = 0; i < gripper.fingerJoints.size(); ++i)
+  {
+    if (std::fabs(*joints_->velocity[gripper.fingerJoints[i]]) > gripper.stallVelocity)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool GraspManager::opened(const Gripper& gripper) const
+{
+  for (size_t i = 0; i < gripper.fingerJoints.size(); ++i)
+  {
+    const double position = *joints_->position[gripper.fingerJoints[i]];
+    if (gripper.openDirection * (position - gripper.graspPositions[i]) >
+        gripper.releaseTolerance)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+void GraspManager::attach(Gripper& gripper, const gazebo::physics::LinkPtr& object)
+{
+  // A revolute joint with null range, fixed joints are not supported by all engines
+#if GAZEBO_MAJOR_VERSION >= 8
+  gazebo::physics::PhysicsEnginePtr physics = model_->GetWorld()->Physics();
+  gripper.attachment = physics->CreateJoint("revolute", model_);
+  gripper.attachment->SetName(gripper.name + "_grasp");
+  gripper.attachment->Load(gripper.palm, object, ignition::math::Pose3d());
+  gripper.attachment->Init();
+  gripper.attachment->SetUpperLimit(0, 0.);
+  gripper.attachment->SetLowerLimit(0, 0.);
+#else
+  gazebo::physics::PhysicsEnginePtr physics = model_->GetWorld()->GetPhysicsEngine();
+  gripper.attachment = physics->CreateJoint("revolute", model_);
+  gripper.attachment->SetName(gripper.name + "_grasp");
+  gripper.attachment->Load(gripper.palm, object, gazebo::math::Pose());
+  gripper.attachment->Init();
+  gripper.attachment->SetHighStop(0, 0.);
+  gripper.attachment->SetLowStop(0, 0.);
+#endif
+
+  for (size_t i = 0; i < gripper.fingerJoints.size(); ++i)
+  {
+    gripper.graspPositions[i] = *joints_->position[gripper.fingerJoints[i]];
+  }
+  gripper.heldTicks = 0;
+  ROS_INFO_STREAM("Gripper " << gripper.name << " grasped " << object->GetScopedName());
+}
+
+void GraspManager::detach(Gripper& gripper)
+{
+  gripper.attachment->Detach();
+  gripper.attachment.reset();
+  gripper.candidate.reset();
+  ROS_INFO_STREAM("Gripper " << gripper.name << " released its object");
+}
+}
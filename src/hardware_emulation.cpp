@@ -0,0 +1,181 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <string>
+
+#include <pal_hardware_gazebo/hardware_emulation.h>
+
+namespace gazebo_ros_control
+{
+DelayLine::DelayLine() : width_(0), delay_(0), head_(0), primed_(false)
+{
+}
+
+void DelayLine::init(size_t width, unsigned int delay)
+{
+  width_ = width;
+  delay_ = delay;
+  head_ = 0;
+  primed_ = false;
+  buffer_.assign(width_ * (delay_ + 1), 0.);
+}
+
+const double* DelayLine::push(const double* sample)
+{
+  const size_t slots = delay_ + 1;
+  if (!primed_)
+  {
+    for (size_t s = 0; s < slots; ++s)
+    {
+      std::copy(sample, sample + width_, &buffer_[s * width_]);
+    }
+    primed_ = true;
+  }
+  else
+  {
+    std::copy(sample, sample + width_, &buffer_[head_ * width_]);
+  }
+
+  // The oldest sample sits right after the one just written
+  const size_t tail = (head_ + 1) % slots;
+  head_ = tail;
+  return &buffer_[tail * width_];
+}
+
+HardwareEmulation::HardwareEmulation() : enabled_(false)
+{
+}
+
+bool HardwareEmulation::init(ros::NodeHandle& nh, const JointBuffers& joints,
+                             const std::vector<double*>& sensor_channels)
+{
+  ros::NodeHandle emulation_nh(nh, "hardware_emulation");
+
+  int sensor_delay = 0;
+  int actuator_delay = 0;
+  emulation_nh.param("sensor_delay_ticks", sensor_delay, 0);
+  emulation_nh.param("actuator_delay_ticks", actuator_delay, 0);
+  if (sensor_delay < 0 || actuator_delay < 0)
+  {
+    ROS_ERROR_STREAM("Transport delays can not be negative");
+    return false;
+  }
+
+  std::map<std::string, double> resolutions;
+  emulation_nh.getParam("encoder_resolution", resolutions);
+  for (size_t i = 0; i < joints.size(); ++i)
+  {
+    std::map<std::string, double>::const_iterator it = resolutions.find(joints.names[i]);
+    if (it == resolutions.end())
+    {
+      continue;
+    }
+    if (it->second <= 0.)
+    {
+      ROS_ERROR_STREAM("Encoder resolution of joint " << it->first << " must be positive");
+      return false;
+    }
+    quantizedPositions_.push_back(joints.position[i]);
+    resolutions_.push_back(it->second);
+    resolutions.erase(it);
+  }
+  for (std::map<std::string, double>::const_iterator it = resolutions.begin();
+       it != resolutions.end(); ++it)
+  {
+    ROS_WARN_STREAM("Encoder resolution given for unknown joint " << it->first);
+  }
+
+  if (sensor_delay > 0)
+  {
+    sensorChannels_ = sensor_channels;
+    sensorSample_.resize(sensorChannels_.size());
+    sensorDelay_.init(sensorChannels_.size(), sensor_delay);
+  }
+
+  if (actuator_delay > 0)
+  {
+    // Every exposed interface, the active one may change on controller switches
+    for (size_t i = 0; i < joints.size(); ++i)
+    {
+      for (size_t t = JointBuffers::POSITION_COMMAND; t <= JointBuffers::EFFORT_COMMAND; ++t)
+      {
+        double* command = joints.commandFor(i, static_cast<JointBuffers::CommandType>(t));
+        if (command)
+        {
+          commandChannels_.push_back(command);
+        }
+      }
+    }
+    commandSample_.resize(commandChannels_.size());
+    actuatorDelay_.init(commandChannels_.size(), actuator_delay);
+  }
+
+  enabled_ = !quantizedPositions_.empty() || !sensorChannels_.empty() ||
+             !commandChannels_.empty();
+  if (enabled_)
+  {
+    ROS_INFO_STREAM("Hardware emulation: " << quantizedPositions_.size()
+                                           << " quantized encoders, sensor delay "
+                                           << sensor_delay << " ticks, actuator delay "
+                                           << actuator_delay << " ticks");
+  }
+  return true;
+}
+
+void HardwareEmulation::processSensors()
+{
+  for (size_t i = 0; i < quantizedPositions_.size(); ++i)
+  {
+    double& position = *quantizedPositions_[i];
+    position = std::floor(position / resolutions_[i] + 0.5) * resolutions_[i];
+  }
+
+  if (sensorChannels_.empty())
+  {
+    return;
+  }
+  for (size_t i = 0; i < sensorChannels_.size(); ++i)
+  {
+    sensorSample_[i] = *sensorChannels_[i];
+  }
+  const double* delayed = sensorDelay_.push(&sensorSample_[0]);
+  for (size_t i = 0; i < sensorChannels_.size(); ++i)
+  {
+    *sensorChannels_[i] = delayed[i];
+  }
+}
+
+void HardwareEmulation::delayCommands()
+{
+  if (commandChannels_.empty())
+  {
+    return;
+  }
+  for (size_t i = 0; i < commandChannels_.size(); ++i)
+  {
+    commandSample_[i] = *commandChannels_[i];
+  }
+  const double* delayed = actuatorDelay_.push(&commandSample_[0]);
+  for (size_t i = 0; i < commandChannels_.size(); ++i)
+  {
+    *commandChannels_[i] = delayed[i];
+  }
+}
+
+void HardwareEmulation::restoreCommands()
+{
+  for (size_t i = 0; i < commandChannels_.size(); ++i)
+  {
+    *commandChannels_[i] = commandSample_[i];
+  }
+}
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <map>
+
+#include <boost/bind.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <pal_hardware_gazebo/hardware_scheduler.h>
+
+namespace gazebo_ros_control
+{
+boost::shared_ptr<HardwareScheduler> HardwareScheduler::forWorld(const std::string& world_name,
+                                                                 size_t threads)
+{
+  static boost::mutex registry_mutex;
+  static std::map<std::string, boost::weak_ptr<HardwareScheduler> > registry;
+
+  boost::unique_lock<boost::mutex> lock(registry_mutex);
+  boost::shared_ptr<HardwareScheduler> scheduler = registry[world_name].lock();
+  if (!scheduler)
+  {
+    scheduler.reset(new HardwareScheduler(threads));
+    registry[world_name] = scheduler;
+    ROS_INFO_STREAM("Created hardware scheduler of world " << world_name << " with "
+                                                           << threads << " threads");
+  }
+  return scheduler;
+}
+
+HardwareScheduler::HardwareScheduler(size_t threads)
+  : pool_(threads)
+  , readDone_(false)
+  , pendingWrites_(0)
+  , readTask_(boost::bind(&HardwareScheduler::readEntry, this, _1))
+  , writeTask_(boost::bind(&HardwareScheduler::writeEntry, this, _1))
+{
+}
+
+void HardwareScheduler::add(ScheduledHardware* hardware)
+{
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  Entry entry;
+  entry.hardware = hardware;
+  entry.writePending = false;
+  entries_.push_back(entry);
+}
+
+void HardwareScheduler::remove(ScheduledHardware* hardware)
+{
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  for (size_t i = 0; i < entries_.size(); ++i)
+  {
+    if (entries_[i].hardware == hardware)
+    {
+      if (entries_[i].writePending)
+      {
+        --pendingWrites_;
+      }
+      entries_.erase(entries_.begin() + i);
+      return;
+    }
+  }
+}
+
+void HardwareScheduler::read(ScheduledHardware* hardware, const ros::Time& time,
+                             const ros::Duration& period)
+{
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  if (readDone_ && time == readTime_)
+  {
+    return;
+  }
+  if (pendingWrites_ > 0)
+  {
+    ROS_WARN_STREAM_THROTTLE(1.0, "Not every scheduled robot wrote in the last tick, "
+                                  "check that they share the same control period");
+    flushWrites();
+  }
+  readTime_ = time;
+  readPeriod_ = period;
+  pool_.run(entries_.size(), readTask_);
+  for (size_t i = 0; i < entries_.size(); ++i)
+  {
+    entries_[i].hardware->readSerial(readTime_, readPeriod_);
+  }
+  readDone_ = true;
+}
+
+void HardwareScheduler::write(ScheduledHardware* hardware, const ros::Time& time,
+                              const ros::Duration& period)
+{
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  for (size_t i = 0; i < entries_.size(); ++i)
+  {
+    Entry& entry = entries_[i];
+    if (entry.hardware == hardware && !entry.writePending)
+    {
+      entry.writePending = true;
+      entry.writeTime = time;
+      entry.writePeriod = period;
+      ++pendingWrites_;
+    }
+  }
+  if (pendingWrites_ == entries_.size())
+  {
+    flushWrites();
+  }
+}
+
+void HardwareScheduler::flushWrites()
+{
+  pool_.run(entries_.size(), writeTask_);
+  for (size_t i = 0; i < entries_.size(); ++i)
+  {
+    Entry& entry = entries_[i];
+    if (entry.writePending)
+    {
+      entry.hardware->writeSerial(entry.writeTime, entry.writePeriod);
+      entry.writePending = false;
+    }
+  }
+  pendingWrites_ = 0;
+}
+
+void HardwareScheduler::readEntry(size_t i)
+{
+  entries_[i].hardware->readHardware(readTime_, readPeriod_);
+}
+
+void HardwareScheduler::writeEntry(size_t i)
+{
+  const Entry& entry = entries_[i];
+  if (entry.writePending)
+  {
+    entry.hardware->writeHardware(entry.writeTime, entry.writePeriod);
+  }
+}
+}
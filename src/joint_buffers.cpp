@@ -0,0 +1,115 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <algorithm>
+
+#include <hardware_interface/joint_state_interface.h>
+#include <hardware_interface/joint_command_interface.h>
+#include <hardware_interface/internal/demangle_symbol.h>
+
+#include <pal_hardware_gazebo/joint_buffers.h>
+
+namespace gazebo_ros_control
+{
+namespace
+{
+template <class Interface>
+bool findCommand(hardware_interface::RobotHW* robot_hw, const std::string& name, double*& command)
+{
+  Interface* iface = robot_hw->get<Interface>();
+  if (!iface)
+  {
+    return false;
+  }
+  const std::vector<std::string> names = iface->getNames();
+  if (std::find(names.begin(), names.end(), name) == names.end())
+  {
+    return false;
+  }
+  command = iface->getHandle(name).getCommandPtr();
+  return true;
+}
+}
+
+bool JointBuffers::init(hardware_interface::RobotHW* robot_hw, gazebo::physics::ModelPtr model)
+{
+  using namespace hardware_interface;
+
+  JointStateInterface* js_interface = robot_hw->get<JointStateInterface>();
+  if (!js_interface)
+  {
+    ROS_ERROR_STREAM("No joint state interface registered, cannot access joint buffers");
+    return false;
+  }
+
+  names = js_interface->getNames();
+  position.resize(names.size());
+  velocity.resize(names.size());
+  effort.resize(names.size());
+  command.resize(names.size(), NULL);
+  commandType.resize(names.size(), NO_COMMAND);
+  simJoints.resize(names.size());
+  for (size_t t = 0; t <= EFFORT_COMMAND; ++t)
+  {
+    typedCommands_[t].assign(names.size(), NULL);
+  }
+
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    // The handles only hand out const pointers, but the memory belongs to the
+    // resources of this very robot and is written by them on every read
+    JointStateHandle handle = js_interface->getHandle(names[i]);
+    position[i] = const_cast<double*>(handle.getPositionPtr());
+    velocity[i] = const_cast<double*>(handle.getVelocityPtr());
+    effort[i] = const_cast<double*>(handle.getEffortPtr());
+
+    findCommand<PositionJointInterface>(robot_hw, names[i], typedCommands_[POSITION_COMMAND][i]);
+    findCommand<VelocityJointInterface>(robot_hw, names[i], typedCommands_[VELOCITY_COMMAND][i]);
+    findCommand<EffortJointInterface>(robot_hw, names[i], typedCommands_[EFFORT_COMMAND][i]);
+
+    // The first exposed interface, in position, velocity, effort order
+    for (size_t t = POSITION_COMMAND; t <= EFFORT_COMMAND && !command[i]; ++t)
+    {
+      command[i] = typedCommands_[t][i];
+      commandType[i] = command[i] ? static_cast<CommandType>(t) : NO_COMMAND;
+    }
+
+    simJoints[i] = model ? model->GetJoint(names[i]) : gazebo::physics::JointPtr();
+  }
+  return nameIndex_.build(names);
+}
+
+std::string JointBuffers::interfaceName(CommandType type)
+{
+  using namespace hardware_interface;
+  switch (type)
+  {
+    case POSITION_COMMAND:
+      return internal::demangledTypeName<PositionJointInterface>();
+    case VELOCITY_COMMAND:
+      return internal::demangledTypeName<VelocityJointInterface>();
+    case EFFORT_COMMAND:
+      return internal::demangledTypeName<EffortJointInterface>();
+    default:
+      return "";
+  }
+}
+
+JointBuffers::CommandType JointBuffers::fromInterfaceName(const std::string& name)
+{
+  for (size_t t = POSITION_COMMAND; t <= EFFORT_COMMAND; ++t)
+  {
+    if (name == interfaceName(static_cast<CommandType>(t)))
+    {
+      return static_cast<CommandType>(t);
+    }
+  }
+  return NO_COMMAND;
+}
+}
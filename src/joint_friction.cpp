@@ -0,0 +1,101 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <algorithm>
+
+#include <pal_hardware_gazebo/joint_friction.h>
+#include <pal_hardware_gazebo/joint_inertia.h>
+
+namespace gazebo_ros_control
+{
+bool JointFriction::init(ros::NodeHandle& nh, const std::vector<std::string>& joint_names,
+                         gazebo::physics::ModelPtr model)
+{
+  const size_t n = joint_names.size();
+  coulomb_.setZero(n);
+  static_.setZero(n);
+  stribeckVelocity_.setZero(n);
+  viscous_.setZero(n);
+  smoothingVelocity_.setZero(n);
+  velocity_.setZero(n);
+  effort_.setZero(n);
+
+  const double dt = physicsStepSize(model->GetWorld());
+
+  ros::NodeHandle friction_nh(nh, "joint_friction");
+  for (size_t i = 0; i < n; ++i)
+  {
+    const std::string& name = joint_names[i];
+    gazebo::physics::JointPtr joint = model->GetJoint(name);
+    if (!joint)
+    {
+      ROS_ERROR_STREAM("Could not find joint '" << name << "' to apply friction to");
+      return false;
+    }
+    joints_.push_back(joint);
+
+    ros::NodeHandle joint_nh(friction_nh, name);
+    joint_nh.param("coulomb", coulomb_(i), 0.);
+    joint_nh.param("static", static_(i), coulomb_(i));
+    joint_nh.param("stribeck_velocity", stribeckVelocity_(i), 0.01);
+    joint_nh.param("viscous", viscous_(i), 0.);
+    joint_nh.param("smoothing_velocity", smoothingVelocity_(i), 1e-3);
+    if (coulomb_(i) < 0. || static_(i) < 0. || viscous_(i) < 0. ||
+        stribeckVelocity_(i) <= 0. || smoothingVelocity_(i) <= 0.)
+    {
+      ROS_ERROR_STREAM("Invalid friction parameters for joint " << name);
+      return false;
+    }
+
+    double inertia;
+    joint_nh.param("inertia", inertia, childLinkInertia(joint));
+    if (inertia <= 0.)
+    {
+      ROS_ERROR_STREAM("Joint " << name << " has no inertia, set joint_friction/" << name
+                                << "/inertia");
+      return false;
+    }
+    if (viscous_(i) * dt >= inertia)
+    {
+      ROS_ERROR_STREAM("Viscous friction of joint " << name << " is unstable with a " << dt
+                                                    << " s step, it must be below "
+                                                    << inertia / dt);
+      return false;
+    }
+    const double min_smoothing =
+        std::max(static_(i), coulomb_(i)) * dt / (inertia - viscous_(i) * dt);
+    if (smoothingVelocity_(i) < min_smoothing)
+    {
+      ROS_WARN_STREAM("Raising the friction smoothing velocity of joint "
+                      << name << " from " << smoothingVelocity_(i) << " to " << min_smoothing
+                      << " to keep it stable with a " << dt << " s step");
+      smoothingVelocity_(i) = min_smoothing;
+    }
+    ROS_INFO_STREAM("Parsed friction of joint: " << name);
+  }
+  return true;
+}
+
+void JointFriction::apply()
+{
+  for (size_t i = 0; i < joints_.size(); ++i)
+  {
+    velocity_(i) = joints_[i]->GetVelocity(0);
+  }
+
+  effort_ = -(coulomb_ + (static_ - coulomb_) * (-(velocity_ / stribeckVelocity_).square()).exp()) *
+                (velocity_ / smoothingVelocity_).tanh() -
+            viscous_ * velocity_;
+
+  for (size_t i = 0; i < joints_.size(); ++i)
+  {
+    joints_[i]->SetForce(0, effort_(i));
+  }
+}
+}
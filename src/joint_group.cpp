@@ -0,0 +1,98 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <ros/ros.h>
+
+#include <pal_hardware_gazebo/joint_group.h>
+
+namespace gazebo_ros_control
+{
+bool JointGroup::init(const std::string& name, const std::vector<std::string>& joint_names,
+                      JointBuffers::CommandType command_type, const JointBuffers& joints)
+{
+  name_ = name;
+  jointNames_ = joint_names;
+  interfaceName_ = JointBuffers::interfaceName(command_type);
+  if (jointNames_.empty())
+  {
+    ROS_ERROR_STREAM("Joint group " << name_ << " has no joints");
+    return false;
+  }
+
+  for (size_t i = 0; i < jointNames_.size(); ++i)
+  {
+    const int index = joints.index(jointNames_[i]);
+    if (index < 0)
+    {
+      ROS_ERROR_STREAM("Joint group " << name_ << " references unknown joint "
+                                      << jointNames_[i]);
+      return false;
+    }
+    double* command = joints.commandFor(index, command_type);
+    if (!command)
+    {
+      ROS_ERROR_STREAM("Joint " << jointNames_[i] << " of group " << name_ << " has no "
+                                << interfaceName_);
+      return false;
+    }
+    indices_.push_back(index);
+    jointPositions_.push_back(joints.position[index]);
+    jointVelocities_.push_back(joints.velocity[index]);
+    jointEfforts_.push_back(joints.effort[index]);
+    jointCommands_.push_back(command);
+  }
+
+  position_.assign(jointNames_.size(), 0.);
+  velocity_.assign(jointNames_.size(), 0.);
+  effort_.assign(jointNames_.size(), 0.);
+  command_.assign(jointNames_.size(), 0.);
+  gatherState();
+  gatherCommands();
+  return true;
+}
+
+JointGroupHandle::Data JointGroup::getHandleData()
+{
+  JointGroupHandle::Data data;
+  data.name = name_;
+  data.command_interface = interfaceName_;
+  data.joint_names = &jointNames_;
+  data.position = &position_[0];
+  data.velocity = &velocity_[0];
+  data.effort = &effort_[0];
+  data.command = &command_[0];
+  return data;
+}
+
+void JointGroup::gatherState()
+{
+  for (size_t i = 0; i < jointNames_.size(); ++i)
+  {
+    position_[i] = *jointPositions_[i];
+    velocity_[i] = *jointVelocities_[i];
+    effort_[i] = *jointEfforts_[i];
+  }
+}
+
+void JointGroup::gatherCommands()
+{
+  for (size_t i = 0; i < jointNames_.size(); ++i)
+  {
+    command_[i] = *jointCommands_[i];
+  }
+}
+
+void JointGroup::scatterCommands()
+{
+  for (size_t i = 0; i < jointNames_.size(); ++i)
+  {
+    *jointCommands_[i] = command_[i];
+  }
+}
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+#include <Eigen/Geometry>
+
+#include <gazebo/gazebo_config.h>
+
+#include <pal_hardware_gazebo/joint_inertia.h>
+
+namespace gazebo_ros_control
+{
+double childLinkInertia(const gazebo::physics::JointPtr& joint)
+{
+  const gazebo::physics::LinkPtr child = joint->GetChild();
+  if (!child || !child->GetInertial())
+  {
+    return 0.;
+  }
+#if GAZEBO_MAJOR_VERSION >= 8
+  const double mass = child->GetInertial()->Mass();
+  const ignition::math::Vector3d a = joint->GlobalAxis(0);
+  const ignition::math::Vector3d p = joint->Anchor(0);
+  const ignition::math::Vector3d c = child->WorldCoGPose().Pos();
+  const ignition::math::Matrix3d I = child->WorldInertiaMatrix();
+  const Eigen::Vector3d axis(a.X(), a.Y(), a.Z());
+  const Eigen::Vector3d lever(c.X() - p.X(), c.Y() - p.Y(), c.Z() - p.Z());
+  Eigen::Matrix3d inertia;
+  for (int r = 0; r < 3; ++r)
+  {
+    for (int col = 0; col < 3; ++col)
+    {
+      inertia(r, col) = I(r, col);
+    }
+  }
+#else
+  const double mass = child->GetInertial()->GetMass();
+  const gazebo::math::Vector3 a = joint->GetGlobalAxis(0);
+  const gazebo::math::Vector3 p = joint->GetAnchor(0);
+  const gazebo::math::Vector3 c = child->GetWorldCoGPose().pos;
+  const gazebo::math::Matrix3 I = child->GetWorldInertiaMatrix();
+  const Eigen::Vector3d axis(a.x, a.y, a.z);
+  const Eigen::Vector3d lever(c.x - p.x, c.y - p.y, c.z - p.z);
+  Eigen::Matrix3d inertia;
+  for (int r = 0; r < 3; ++r)
+  {
+    for (int col = 0; col < 3; ++col)
+    {
+      inertia(r, col) = I[r][col];
+    }
+  }
+#endif
+  if (joint->HasType(gazebo::physics::Base::SLIDER_JOINT))
+  {
+    return mass;
+  }
+  const Eigen::Vector3d u = axis.normalized();
+  return u.dot(inertia * u) + mass * lever.cross(u).squaredNorm();
+}
+
+double physicsStepSize(const gazebo::physics::WorldPtr& world)
+{
+#if GAZEBO_MAJOR_VERSION >= 8
+  return world->Physics()->GetMaxStepSize();
+#else
+  return world->GetPhysicsEngine()->GetMaxStepSize();
+#endif
+}
+}
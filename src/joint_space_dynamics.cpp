@@ -0,0 +1,335 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+
+#include <Eigen/Geometry>
+
+#include <ros/ros.h>
+
+#include <pal_hardware_gazebo/joint_space_dynamics.h>
+
+namespace gazebo_ros_control
+{
+namespace
+{
+typedef JointSpaceDynamics::SpatialVector SpatialVector;
+typedef JointSpaceDynamics::SpatialMatrix SpatialMatrix;
+
+Eigen::Matrix3d skew(const Eigen::Vector3d& v)
+{
+  Eigen::Matrix3d m;
+  m << 0., -v(2), v(1), v(2), 0., -v(0), -v(1), v(0), 0.;
+  return m;
+}
+
+// Spatial vectors are stored as [angular; linear]
+SpatialMatrix motionCross(const SpatialVector& v)
+{
+  SpatialMatrix m;
+  m.setZero();
+  m.topLeftCorner<3, 3>() = skew(v.head<3>());
+  m.bottomRightCorner<3, 3>() = m.topLeftCorner<3, 3>();
+  m.bottomLeftCorner<3, 3>() = skew(v.tail<3>());
+  return m;
+}
+
+SpatialMatrix forceCross(const SpatialVector& v)
+{
+  return -motionCross(v).transpose();
+}
+
+/// Motion transform from parent to child, given the child pose in the parent
+SpatialMatrix plucker(const Eigen::Matrix3d& rotation, const Eigen::Vector3d& translation)
+{
+  SpatialMatrix X;
+  const Eigen::Matrix3d E = rotation.transpose();
+  X.setZero();
+  X.topLeftCorner<3, 3>() = E;
+  X.bottomRightCorner<3, 3>() = E;
+  X.bottomLeftCorner<3, 3>() = -E * skew(translation);
+  return X;
+}
+
+Eigen::Vector3d toEigen(const urdf::Vector3& v)
+{
+  return Eigen::Vector3d(v.x, v.y, v.z);
+}
+
+Eigen::Matrix3d toEigen(const urdf::Rotation& r)
+{
+  return Eigen::Quaterniond(r.w, r.x, r.y, r.z).toRotationMatrix();
+}
+
+SpatialMatrix spatialInertia(const urdf::Inertial* inertial)
+{
+  SpatialMatrix I;
+  I.setZero();
+  if (!inertial)
+  {
+    return I;
+  }
+  Eigen::Matrix3d I_com;
+  I_com << inertial->ixx, inertial->ixy, inertial->ixz, inertial->ixy, inertial->iyy,
+      inertial->iyz, inertial->ixz, inertial->iyz, inertial->izz;
+  const Eigen::Matrix3d R = toEigen(inertial->origin.rotation);
+  I_com = R * I_com * R.transpose();
+
+  const double m = inertial->mass;
+  const Eigen::Matrix3d cx = skew(toEigen(inertial->origin.position));
+  I.topLeftCorner<3, 3>() = I_com - m * cx * cx;
+  I.topRightCorner<3, 3>() = m * cx;
+  I.bottomLeftCorner<3, 3>() = -m * cx;
+  I.bottomRightCorner<3, 3>() = m * Eigen::Matrix3d::Identity();
+  return I;
+}
+}
+
+JointSpaceDynamics::JointSpaceDynamics()
+  : tick_(1), kinematicsTick_(0), massMatrixTick_(0), gravityTick_(0), coriolisTick_(0)
+{
+}
+
+bool JointSpaceDynamics::init(const urdf::Model& urdf_model, const JointBuffers& joints,
+                              const Eigen::Vector3d& gravity)
+{
+  boost::shared_ptr<const urdf::Link> root = urdf_model.getRoot();
+  if (!root)
+  {
+    ROS_ERROR_STREAM("Robot model has no root link, cannot build its dynamics");
+    return false;
+  }
+
+  bodies_.clear();
+  jointNames_.clear();
+  addSubtree(*root, -1, joints);
+
+  for (size_t i = 0; i < jointNames_.size(); ++i)
+  {
+    const int idx = joints.index(jointNames_[i]);
+    positions_.push_back(joints.position[idx]);
+    velocities_.push_back(joints.velocity[idx]);
+  }
+
+  // Gravity is emulated by accelerating the fixed root upwards
+  rootAcceleration_.setZero();
+  rootAcceleration_.tail<3>() = -gravity;
+
+  const size_t n_dof = jointNames_.size();
+  q_.setZero(n_dof);
+  qd_.setZero(n_dof);
+  massMatrix_.setZero(n_dof, n_dof);
+  gravity_.setZero(n_dof);
+  coriolis_.setZero(n_dof);
+
+  const size_t n_bodies = bodies_.size();
+  Xup_.resize(n_bodies);
+  S_.assign(n_bodies, SpatialVector::Zero());
+  v_.resize(n_bodies);
+  a_.resize(n_bodies);
+  f_.resize(n_bodies);
+  Ic_.resize(n_bodies);
+
+  ROS_INFO_STREAM("Built joint-space dynamics with " << n_bodies << " bodies and " << n_dof
+                                                     << " degrees of freedom");
+  return true;
+}
+
+void JointSpaceDynamics::addSubtree(const urdf::Link& link, int parent,
+                                    const JointBuffers& joints)
+{
+  Body body;
+  body.parent = parent;
+  body.dof = -1;
+  body.prismatic = false;
+  body.axis.setZero();
+  body.originRotation.setIdentity();
+  body.originTranslation.setZero();
+  body.inertia = spatialInertia(link.inertial.get());
+
+  if (const urdf::Joint* joint = link.parent_joint.get())
+  {
+    const urdf::Pose& origin = joint->parent_to_joint_origin_transform;
+    body.originRotation = toEigen(origin.rotation);
+    body.originTranslation = toEigen(origin.position);
+    body.axis = toEigen(joint->axis);
+
+    const bool movable = joint->type == urdf::Joint::REVOLUTE ||
+                         joint->type == urdf::Joint::CONTINUOUS ||
+                         joint->type == urdf::Joint::PRISMATIC;
+    if (joint->type == urdf::Joint::FLOATING || joint->type == urdf::Joint::PLANAR)
+    {
+      ROS_WARN_STREAM("Joint " << joint->name << " is not supported by the joint-space "
+                                                 "dynamics, it will be considered fixed");
+    }
+    else if (movable && joints.index(joint->name) >= 0)
+    {
+      body.dof = jointNames_.size();
+      body.prismatic = joint->type == urdf::Joint::PRISMATIC;
+      jointNames_.push_back(joint->name);
+    }
+  }
+
+  const int index = bodies_.size();
+  bodies_.push_back(body);
+  for (size_t i = 0; i < link.child_links.size(); ++i)
+  {
+    addSubtree(*link.child_links[i], index, joints);
+  }
+}
+
+void JointSpaceDynamics::readState()
+{
+  for (size_t i = 0; i < positions_.size(); ++i)
+  {
+    q_(i) = *positions_[i];
+    qd_(i) = *velocities_[i];
+  }
+}
+
+void JointSpaceDynamics::updateKinematics()
+{
+  if (kinematicsTick_ == tick_)
+  {
+    return;
+  }
+  readState();
+
+  for (size_t i = 0; i < bodies_.size(); ++i)
+  {
+    const Body& body = bodies_[i];
+    Eigen::Matrix3d rotation = body.originRotation;
+    Eigen::Vector3d translation = body.originTranslation;
+    if (body.dof >= 0)
+    {
+      const double q = q_(body.dof);
+      if (body.prismatic)
+      {
+        translation += body.originRotation * (body.axis * q);
+        S_[i].tail<3>() = body.axis;
+      }
+      else
+      {
+        rotation = rotation * Eigen::AngleAxisd(q, body.axis).toRotationMatrix();
+        S_[i].head<3>() = body.axis;
+      }
+    }
+    Xup_[i] = plucker(rotation, translation);
+  }
+  kinematicsTick_ = tick_;
+}
+
+void JointSpaceDynamics::inverseDynamics(bool velocity_terms, Eigen::VectorXd& tau)
+{
+  updateKinematics();
+
+  const SpatialVector root_acceleration =
+      velocity_terms ? SpatialVector::Zero() : rootAcceleration_;
+  for (size_t i = 0; i < bodies_.size(); ++i)
+  {
+    const Body& body = bodies_[i];
+    SpatialVector vJ = SpatialVector::Zero();
+    if (velocity_terms && body.dof >= 0)
+    {
+      vJ = S_[i] * qd_(body.dof);
+    }
+    if (body.parent < 0)
+    {
+      v_[i] = vJ;
+      a_[i] = Xup_[i] * root_acceleration;
+    }
+    else
+    {
+      v_[i] = Xup_[i] * v_[body.parent] + vJ;
+      a_[i] = Xup_[i] * a_[body.parent] + motionCross(v_[i]) * vJ;
+    }
+    f_[i] = body.inertia * a_[i] + forceCross(v_[i]) * (body.inertia * v_[i]);
+  }
+
+  for (int i = bodies_.size() - 1; i >= 0; --i)
+  {
+    const Body& body = bodies_[i];
+    if (body.dof >= 0)
+    {
+      tau(body.dof) = S_[i].dot(f_[i]);
+    }
+    if (body.parent >= 0)
+    {
+      f_[body.parent] += Xup_[i].transpose() * f_[i];
+    }
+  }
+}
+
+const Eigen::MatrixXd& JointSpaceDynamics::getMassMatrix()
+{
+  if (massMatrixTick_ == tick_)
+  {
+    return massMatrix_;
+  }
+  updateKinematics();
+
+  for (size_t i = 0; i < bodies_.size(); ++i)
+  {
+    Ic_[i] = bodies_[i].inertia;
+  }
+  for (int i = bodies_.size() - 1; i >= 0; --i)
+  {
+    const int parent = bodies_[i].parent;
+    if (parent >= 0)
+    {
+      Ic_[parent] += Xup_[i].transpose() * Ic_[i] * Xup_[i];
+    }
+  }
+
+  for (size_t i = 0; i < bodies_.size(); ++i)
+  {
+    const int dof = bodies_[i].dof;
+    if (dof < 0)
+    {
+      continue;
+    }
+    SpatialVector F = Ic_[i] * S_[i];
+    massMatrix_(dof, dof) = S_[i].dot(F);
+
+    int j = i;
+    while (bodies_[j].parent >= 0)
+    {
+      F = Xup_[j].transpose() * F;
+      j = bodies_[j].parent;
+      const int parent_dof = bodies_[j].dof;
+      if (parent_dof >= 0)
+      {
+        massMatrix_(dof, parent_dof) = F.dot(S_[j]);
+        massMatrix_(parent_dof, dof) = massMatrix_(dof, parent_dof);
+      }
+    }
+  }
+  massMatrixTick_ = tick_;
+  return massMatrix_;
+}
+
+const Eigen::VectorXd& JointSpaceDynamics::getGravity()
+{
+  if (gravityTick_ != tick_)
+  {
+    inverseDynamics(false, gravity_);
+    gravityTick_ = tick_;
+  }
+  return gravity_;
+}
+
+const Eigen::VectorXd& JointSpaceDynamics::getCoriolis()
+{
+  if (coriolisTick_ != tick_)
+  {
+    inverseDynamics(true, coriolis_);
+    coriolisTick_ = tick_;
+  }
+  return coriolis_;
+}
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <cmath>
+
+#include <gazebo/gazebo_config.h>
+
+#include <pal_hardware_gazebo/kinematic_base.h>
+
+namespace gazebo_ros_control
+{
+KinematicBase::KinematicBase() : enabled_(false), geometry_(NULL), joints_(NULL)
+{
+}
+
+bool KinematicBase::init(ros::NodeHandle& nh, const DiffDriveGeometry& geometry,
+                         JointBuffers& joints, gazebo::physics::ModelPtr model)
+{
+  nh.param("mobile_base/kinematic", enabled_, false);
+  if (!enabled_)
+  {
+    return true;
+  }
+
+  std::string base_link;
+  nh.param<std::string>("mobile_base/base_link", base_link, "");
+  baseLink_ = base_link.empty() ? model->GetLink() : model->GetLink(base_link);
+  if (!baseLink_)
+  {
+    ROS_ERROR_STREAM("Could not find mobile base link '" << base_link << "'");
+    enabled_ = false;
+    return false;
+  }
+
+  geometry_ = &geometry;
+  joints_ = &joints;
+  wheels_ = geometry.leftWheels;
+  wheels_.insert(wheels_.end(), geometry.rightWheels.begin(), geometry.rightWheels.end());
+  for (size_t i = 0; i < wheels_.size(); ++i)
+  {
+    if (joints.commandType[wheels_[i]] != JointBuffers::VELOCITY_COMMAND)
+    {
+      ROS_ERROR_STREAM("Wheel joint " << joints.names[wheels_[i]]
+                                      << " needs a velocity interface for a kinematic base");
+      enabled_ = false;
+      return false;
+    }
+    wheelPositions_.push_back(*joints.position[wheels_[i]]);
+  }
+  ROS_INFO_STREAM("Mobile base link " << baseLink_->GetName()
+                                      << " driven kinematically, wheel contacts are bypassed");
+  return true;
+}
+
+bool KinematicBase::isWheel(const std::string& name) const
+{
+  const int index = joints_->index(name);
+  for (size_t i = 0; i < wheels_.size(); ++i)
+  {
+    if (index >= 0 && wheels_[i] == static_cast<size_t>(index))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+void KinematicBase::setResources(const std::vector<std::string>& names)
+{
+  ownedResources_.resize(names.size());
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    ownedResources_[i] = isWheel(names[i]);
+  }
+}
+
+void KinematicBase::setActiveResources(const std::vector<std::string>& names)
+{
+  ownedActiveResources_.resize(names.size());
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    ownedActiveResources_[i] = isWheel(names[i]);
+  }
+}
+
+void KinematicBase::read(const ros::Duration& period)
+{
+  const double dt = period.toSec();
+  for (size_t i = 0; i < wheels_.size(); ++i)
+  {
+    const size_t w = wheels_[i];
+    const double velocity = *joints_->command[w];
+    wheelPositions_[i] += velocity * dt;
+    *joints_->velocity[w] = velocity;
+    *joints_->position[w] = wheelPositions_[i];
+    *joints_->effort[w] = 0.;
+  }
+}
+
+void KinematicBase::write()
+{
+  double linear, angular;
+  geometry_->twist(DiffDriveGeometry::mean(geometry_->leftWheels, joints_->command),
+                   DiffDriveGeometry::mean(geometry_->rightWheels, joints_->command), linear,
+                   angular);
+
+#if GAZEBO_MAJOR_VERSION >= 8
+  const double yaw = baseLink_->WorldPose().Rot().Yaw();
+  baseLink_->SetLinearVel(
+      ignition::math::Vector3d(linear * std::cos(yaw), linear * std::sin(yaw), 0.));
+  baseLink_->SetAngularVel(ignition::math::Vector3d(0., 0., angular));
+#else
+  const double yaw = baseLink_->GetWorldPose().rot.GetYaw();
+  baseLink_->SetLinearVel(
+      gazebo::math::Vector3(linear * std::cos(yaw), linear * std::sin(yaw), 0.));
+  baseLink_->SetAngularVel(gazebo::math::Vector3(0., 0., angular));
+#endif
+}
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <pal_hardware_gazebo/lazy_joint_reader.h>
+
+namespace gazebo_ros_control
+{
+void JointReadRequestHandle::requestRead()
+{
+  reader_->requestRead(joint_);
+}
+
+void JointReadRequestHandle::pin()
+{
+  reader_->pin(joint_);
+}
+
+void JointReadRequestHandle::release()
+{
+  reader_->release(joint_);
+}
+
+LazyJointReader::LazyJointReader()
+  : enabled_(false), backgroundDivider_(10), backgroundFactor_(1), tick_(0), joints_(NULL)
+{
+}
+
+bool LazyJointReader::init(ros::NodeHandle& nh, const JointBuffers& joints)
+{
+  ros::NodeHandle lazy_nh(nh, "lazy_read");
+  lazy_nh.param("enabled", enabled_, false);
+  if (!enabled_)
+  {
+    return true;
+  }
+
+  int divider;
+  lazy_nh.param("background_divider", divider, 10);
+  if (divider < 0)
+  {
+    ROS_ERROR_STREAM("Lazy read background divider can not be negative");
+    enabled_ = false;
+    return false;
+  }
+  backgroundDivider_ = divider;
+
+  joints_ = &joints;
+  consumed_ = ResourceBitset(joints.size());
+  claimed_ = ResourceBitset(joints.size());
+  referenced_ = ResourceBitset(joints.size());
+  pinCount_.assign(joints.size(), 0);
+  requested_.assign(joints.size(), 0);
+
+  std::vector<std::string> always_read;
+  lazy_nh.getParam("always_read", always_read);
+  for (size_t i = 0; i < always_read.size(); ++i)
+  {
+    const int joint = joints.index(always_read[i]);
+    if (joint < 0)
+    {
+      ROS_ERROR_STREAM("Unknown joint " << always_read[i] << " in lazy_read/always_read");
+      enabled_ = false;
+      return false;
+    }
+    consumed_.set(joint);
+  }
+  return true;
+}
+
+void LazyJointReader::addConsumed(size_t joint)
+{
+  consumed_.set(joint);
+}
+
+void LazyJointReader::addAllConsumed()
+{
+  for (size_t i = 0; i < consumed_.size(); ++i)
+  {
+    consumed_.set(i);
+  }
+}
+
+void LazyJointReader::setResources(const std::vector<std::string>& names)
+{
+  resourceJoints_.resize(names.size());
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    resourceJoints_[i] = joints_->index(names[i]);
+  }
+}
+
+void LazyJointReader::update(const ResourceBitset& claimed)
+{
+  claimed_ = claimed;
+  referenced_ = consumed_;
+  referenced_ |= claimed_;
+  for (size_t i = 0; i < pinCount_.size(); ++i)
+  {
+    if (pinCount_[i] > 0)
+    {
+      referenced_.set(i);
+    }
+  }
+}
+
+void LazyJointReader::newTick()
+{
+  ++tick_;
+}
+
+void LazyJointReader::pin(size_t joint)
+{
+  if (pinCount_[joint]++ == 0)
+  {
+    referenced_.set(joint);
+  }
+}
+
+void LazyJointReader::release(size_t joint)
+{
+  if (pinCount_[joint] > 0 && --pinCount_[joint] == 0 && !consumed_.test(joint) &&
+      !claimed_.test(joint))
+  {
+    referenced_.reset(joint);
+  }
+}
+
+void LazyJointReader::registerHandles(JointReadRequestInterface& iface)
+{
+  for (size_t i = 0; i < joints_->size(); ++i)
+  {
+    iface.registerHandle(JointReadRequestHandle(joints_->names[i], this, i));
+  }
+}
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <pal_hardware_gazebo/load_shedder.h>
+
+namespace gazebo_ros_control
+{
+LoadShedder::LoadShedder()
+  : enabled_(false)
+  , budget_(0.)
+  , budgetFraction_(0.5)
+  , windowTicks_(100)
+  , overrunRatio_(0.2)
+  , headroom_(0.7)
+  , recoverWindows_(5)
+  , shedFactor_(4)
+  , level_(0)
+  , tickCost_(boost::chrono::steady_clock::duration::zero())
+  , ticks_(0)
+  , overruns_(0)
+  , windowCost_(0.)
+  , windowBudget_(0.)
+  , calmWindows_(0)
+{
+}
+
+bool LoadShedder::init(ros::NodeHandle& nh)
+{
+  ros::NodeHandle shed_nh(nh, "load_shedding");
+  shed_nh.param("enabled", enabled_, false);
+  if (!enabled_)
+  {
+    return true;
+  }
+
+  int shed_factor;
+  shed_nh.param("budget", budget_, 0.);
+  shed_nh.param("budget_fraction", budgetFraction_, 0.5);
+  shed_nh.param("window_ticks", windowTicks_, 100);
+  shed_nh.param("overrun_ratio", overrunRatio_, 0.2);
+  shed_nh.param("headroom", headroom_, 0.7);
+  shed_nh.param("recover_windows", recoverWindows_, 5);
+  shed_nh.param("shed_factor", shed_factor, 4);
+  if (budget_ < 0. || budgetFraction_ <= 0. || windowTicks_ <= 0 || overrunRatio_ < 0. ||
+      headroom_ <= 0. || headroom_ > 1. || recoverWindows_ <= 0 || shed_factor < 2)
+  {
+    ROS_ERROR_STREAM("Invalid load shedding parameters");
+    return false;
+  }
+  shedFactor_ = shed_factor;
+  return true;
+}
+
+void LoadShedder::addTask(const std::string& name, const FactorSetter& setter)
+{
+  Task task;
+  task.name = name;
+  task.setter = setter;
+  tasks_.push_back(task);
+}
+
+void LoadShedder::endTick(const ros::Duration& period)
+{
+  const double cost = boost::chrono::duration<double>(tickCost_).count();
+  const double budget = budget_ > 0. ? budget_ : budgetFraction_ * period.toSec();
+  tickCost_ = boost::chrono::steady_clock::duration::zero();
+
+  overruns_ += cost > budget;
+  windowCost_ += cost;
+  windowBudget_ += budget;
+  if (++ticks_ >= windowTicks_)
+  {
+    endWindow();
+  }
+}
+
+void LoadShedder::endWindow()
+{
+  const double mean_cost = windowCost_ / ticks_;
+  const double mean_budget = windowBudget_ / ticks_;
+  const bool overloaded = overruns_ > overrunRatio_ * ticks_;
+  const bool calm = overruns_ == 0 && windowCost_ < headroom_ * windowBudget_;
+
+  if (overloaded && level_ < tasks_.size())
+  {
+    Task& task = tasks_[level_++];
+    task.setter(shedFactor_);
+    ROS_WARN_STREAM("Hardware tick over budget (" << overruns_ << "/" << ticks_
+                                                  << " ticks, mean " << mean_cost * 1e6
+                                                  << " us for " << mean_budget * 1e6
+                                                  << " us), shedding " << task.name);
+  }
+
+  calmWindows_ = calm ? calmWindows_ + 1 : 0;
+  if (calmWindows_ >= recoverWindows_ && level_ > 0)
+  {
+    Task& task = tasks_[--level_];
+    task.setter(1);
+    calmWindows_ = 0;
+    ROS_INFO_STREAM("Hardware tick back within budget (mean "
+                    << mean_cost * 1e6 << " us for " << mean_budget * 1e6 << " us), restoring "
+                    << task.name);
+  }
+
+  ticks_ = 0;
+  overruns_ = 0;
+  windowCost_ = 0.;
+  windowBudget_ = 0.;
+}
+}
@@ -0,0 +1,384 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <sstream>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <boost/weak_ptr.hpp>
+
+#include <pal_hardware_gazebo/metrics_exporter.h>
+
+namespace gazebo_ros_control
+{
+namespace
+{
+int64_t steadyNanoseconds()
+{
+  return boost::chrono::duration_cast<boost::chrono::nanoseconds>(
+             boost::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+bool sendAll(int fd, const std::string& data)
+{
+  size_t sent = 0;
+  while (sent < data.size())
+  {
+    const ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (n <= 0)
+    {
+      return false;
+    }
+    sent += n;
+  }
+  return true;
+}
+}
+
+const double LatencyHistogram::BOUNDS[LatencyHistogram::BUCKETS] = {
+  1e-5, 2.5e-5, 5e-5, 1e-4, 2.5e-4, 5e-4, 1e-3, 2.5e-3, 5e-3, 1e-2, 1e-1, 1.
+};
+
+LatencyHistogram::LatencyHistogram() : sumNs_(0)
+{
+  for (size_t i = 0; i <= BUCKETS; ++i)
+  {
+    counts_[i] = 0;
+  }
+}
+
+void LatencyHistogram::observe(const boost::chrono::steady_clock::duration& latency)
+{
+  const double seconds = boost::chrono::duration<double>(latency).count();
+  size_t bucket = 0;
+  while (bucket < BUCKETS && seconds > BOUNDS[bucket])
+  {
+    ++bucket;
+  }
+  counts_[bucket].fetch_add(1, std::memory_order_relaxed);
+  sumNs_.fetch_add(boost::chrono::duration_cast<boost::chrono::nanoseconds>(latency).count(),
+                   std::memory_order_relaxed);
+}
+
+void LatencyHistogram::render(std::ostream& out, const std::string& name,
+                              const std::string& labels) const
+{
+  uint64_t count = 0;
+  for (size_t i = 0; i <= BUCKETS; ++i)
+  {
+    count += counts_[i].load(std::memory_order_relaxed);
+    out << name << "_bucket{" << labels << ",le=\"";
+    if (i < BUCKETS)
+    {
+      out << BOUNDS[i];
+    }
+    else
+    {
+      out << "+Inf";
+    }
+    out << "\"} " << count << "\n";
+  }
+  out << name << "_sum{" << labels << "} " << sumNs_.load(std::memory_order_relaxed) * 1e-9
+      << "\n";
+  out << name << "_count{" << labels << "} " << count << "\n";
+}
+
+boost::shared_ptr<MetricsServer> MetricsServer::forPort(int port)
+{
+  static boost::mutex registry_mutex;
+  static std::map<int, boost::weak_ptr<MetricsServer> > registry;
+
+  boost::unique_lock<boost::mutex> lock(registry_mutex);
+  boost::shared_ptr<MetricsServer> server = registry[port].lock();
+  if (!server)
+  {
+    server.reset(new MetricsServer());
+    if (!server->start(port))
+    {
+      return boost::shared_ptr<MetricsServer>();
+    }
+    registry[port] = server;
+  }
+  return server;
+}
+
+MetricsServer::MetricsServer() : socket_(-1), running_(false)
+{
+}
+
+MetricsServer::~MetricsServer()
+{
+  if (running_)
+  {
+    running_ = false;
+    serverThread_.join();
+  }
+  if (socket_ >= 0)
+  {
+    close(socket_);
+  }
+}
+
+bool MetricsServer::start(int port)
+{
+  // Only reachable from the local machine
+  sockaddr_in address;
+  std::memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  const int reuse = 1;
+  socket_ = socket(AF_INET, SOCK_STREAM, 0);
+  if (socket_ < 0 || setsockopt(socket_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0 ||
+      bind(socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+      listen(socket_, 4) != 0)
+  {
+    ROS_WARN_STREAM("Could not serve metrics on 127.0.0.1:" << port << ": "
+                                                            << std::strerror(errno));
+    return false;
+  }
+
+  running_ = true;
+  serverThread_ = boost::thread(&MetricsServer::serve, this);
+  ROS_INFO_STREAM("Serving metrics on http://127.0.0.1:" << port << "/metrics");
+  return true;
+}
+
+void MetricsServer::add(const MetricsExporter* exporter)
+{
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  exporters_.push_back(exporter);
+}
+
+void MetricsServer::remove(const MetricsExporter* exporter)
+{
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  exporters_.erase(std::remove(exporters_.begin(), exporters_.end(), exporter),
+                   exporters_.end());
+}
+
+void MetricsServer::serve()
+{
+  char request[1024];
+  while (running_)
+  {
+    // Wakes up regularly to notice the shutdown
+    pollfd fd;
+    fd.fd = socket_;
+    fd.events = POLLIN;
+    if (poll(&fd, 1, 200) <= 0)
+    {
+      continue;
+    }
+    const int client = accept(socket_, NULL, NULL);
+    if (client < 0)
+    {
+      continue;
+    }
+
+    // The request is not parsed, every path serves the metrics
+    timeval timeout;
+    timeout.tv_sec = 1;
+    timeout.tv_usec = 0;
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    recv(client, request, sizeof(request), 0);
+
+    std::ostringstream body;
+    body.precision(12);
+    render(body);
+    std::ostringstream response;
+    response << "HTTP/1.0 200 OK\r\n"
+             << "Content-Type: text/plain; version=0.0.4\r\n"
+             << "Content-Length: " << body.str().size() << "\r\n"
+             << "Connection: close\r\n\r\n"
+             << body.str();
+    sendAll(client, response.str());
+    close(client);
+  }
+}
+
+void MetricsServer::render(std::ostream& out)
+{
+  // Each family is declared once, with the samples of every robot
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  for (size_t i = 0; i < MetricsExporter::FAMILY_COUNT; ++i)
+  {
+    const MetricsExporter::Family family = static_cast<MetricsExporter::Family>(i);
+    MetricsExporter::renderType(out, family);
+    for (size_t j = 0; j < exporters_.size(); ++j)
+    {
+      exporters_[j]->render(out, family);
+    }
+  }
+}
+
+MetricsExporter::MetricsExporter()
+  : enabled_(false)
+  , budget_(0.)
+  , budgetFraction_(0.5)
+  , ticks_(0)
+  , overruns_(0)
+  , tickCost_(boost::chrono::steady_clock::duration::zero())
+  , switchRequestNs_(0)
+{
+}
+
+MetricsExporter::~MetricsExporter()
+{
+  if (server_)
+  {
+    server_->remove(this);
+  }
+}
+
+bool MetricsExporter::init(ros::NodeHandle& nh, const std::string& robot,
+                           const std::vector<std::string>& sensor_names)
+{
+  ros::NodeHandle metrics_nh(nh, "metrics");
+  metrics_nh.param("enabled", enabled_, false);
+  if (!enabled_)
+  {
+    return true;
+  }
+
+  int port;
+  metrics_nh.param("port", port, 9464);
+  metrics_nh.param("budget", budget_, 0.);
+  metrics_nh.param("budget_fraction", budgetFraction_, 0.5);
+  if (port <= 0 || port > 65535 || budget_ < 0. || budgetFraction_ <= 0.)
+  {
+    ROS_ERROR_STREAM("Invalid metrics parameters");
+    return false;
+  }
+
+  labels_ = "robot=\"" + robot + "\"";
+  sensorNames_ = sensor_names;
+  sensorFlags_.reset(new std::atomic<unsigned int>[sensorNames_.size()]);
+  sensorUnchangedTicks_.reset(new std::atomic<int>[sensorNames_.size()]);
+  for (size_t i = 0; i < sensorNames_.size(); ++i)
+  {
+    setSensorHealth(i, 0, 0);
+  }
+
+  // Still counted when not served, the simulation does not depend on them
+  server_ = MetricsServer::forPort(port);
+  if (server_)
+  {
+    server_->add(this);
+  }
+  return true;
+}
+
+void MetricsExporter::endTick(const ros::Duration& period)
+{
+  const double cost = boost::chrono::duration<double>(tickCost_).count();
+  const double budget = budget_ > 0. ? budget_ : budgetFraction_ * period.toSec();
+  tickCost_ = boost::chrono::steady_clock::duration::zero();
+
+  ticks_.fetch_add(1, std::memory_order_relaxed);
+  if (cost > budget)
+  {
+    overruns_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void MetricsExporter::switchRequested()
+{
+  switchRequestNs_ = steadyNanoseconds();
+}
+
+void MetricsExporter::switchDone()
+{
+  const int64_t requested = switchRequestNs_.exchange(0);
+  if (requested != 0)
+  {
+    switchLatency_.observe(boost::chrono::nanoseconds(steadyNanoseconds() - requested));
+  }
+}
+
+void MetricsExporter::renderType(std::ostream& out, Family family)
+{
+  switch (family)
+  {
+    case TICK_PHASE_SECONDS:
+      out << "# TYPE pal_hardware_gazebo_tick_phase_seconds histogram\n";
+      break;
+    case TICKS_TOTAL:
+      out << "# TYPE pal_hardware_gazebo_ticks_total counter\n";
+      break;
+    case TICK_OVERRUNS_TOTAL:
+      out << "# TYPE pal_hardware_gazebo_tick_overruns_total counter\n";
+      break;
+    case CONTROLLER_SWITCH_SECONDS:
+      out << "# TYPE pal_hardware_gazebo_controller_switch_seconds histogram\n";
+      break;
+    case SENSOR_UNCHANGED_TICKS:
+      out << "# TYPE pal_hardware_gazebo_sensor_unchanged_ticks gauge\n";
+      break;
+    case SENSOR_HEALTH_FLAGS:
+      out << "# TYPE pal_hardware_gazebo_sensor_health_flags gauge\n";
+      break;
+    default:
+      break;
+  }
+}
+
+void MetricsExporter::render(std::ostream& out, Family family) const
+{
+  const char* phases[] = { "read", "write" };
+  switch (family)
+  {
+    case TICK_PHASE_SECONDS:
+      for (size_t i = 0; i < PHASE_COUNT; ++i)
+      {
+        phases_[i].render(out, "pal_hardware_gazebo_tick_phase_seconds",
+                          labels_ + ",phase=\"" + phases[i] + "\"");
+      }
+      break;
+    case TICKS_TOTAL:
+      out << "pal_hardware_gazebo_ticks_total{" << labels_ << "} "
+          << ticks_.load(std::memory_order_relaxed) << "\n";
+      break;
+    case TICK_OVERRUNS_TOTAL:
+      out << "pal_hardware_gazebo_tick_overruns_total{" << labels_ << "} "
+          << overruns_.load(std::memory_order_relaxed) << "\n";
+      break;
+    case CONTROLLER_SWITCH_SECONDS:
+      switchLatency_.render(out, "pal_hardware_gazebo_controller_switch_seconds", labels_);
+      break;
+    case SENSOR_UNCHANGED_TICKS:
+      for (size_t i = 0; i < sensorNames_.size(); ++i)
+      {
+        out << "pal_hardware_gazebo_sensor_unchanged_ticks{" << labels_ << ",sensor=\""
+            << sensorNames_[i] << "\"} "
+            << sensorUnchangedTicks_[i].load(std::memory_order_relaxed) << "\n";
+      }
+      break;
+    case SENSOR_HEALTH_FLAGS:
+      for (size_t i = 0; i < sensorNames_.size(); ++i)
+      {
+        out << "pal_hardware_gazebo_sensor_health_flags{" << labels_ << ",sensor=\""
+            << sensorNames_[i] << "\"} " << sensorFlags_[i].load(std::memory_order_relaxed)
+            << "\n";
+      }
+      break;
+    default:
+      break;
+  }
+}
+}
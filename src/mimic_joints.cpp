@@ -0,0 +1,131 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <map>
+
+#include <gazebo/gazebo_config.h>
+
+#include <pal_hardware_gazebo/joint_inertia.h>
+#include <pal_hardware_gazebo/mimic_joints.h>
+
+namespace gazebo_ros_control
+{
+namespace
+{
+double jointPosition(const gazebo::physics::JointPtr& joint)
+{
+#if GAZEBO_MAJOR_VERSION >= 8
+  return joint->Position(0);
+#else
+  return joint->GetAngle(0).Radian();
+#endif
+}
+}
+
+MimicJoints::MimicJoints() : enabled_(false)
+{
+}
+
+bool MimicJoints::init(ros::NodeHandle& nh, const urdf::Model& urdf_model,
+                       gazebo::physics::ModelPtr model)
+{
+  ros::NodeHandle mimic_nh(nh, "mimic_joints");
+  mimic_nh.param("enabled", enabled_, false);
+  if (!enabled_)
+  {
+    return true;
+  }
+
+  double default_kp, default_kd;
+  mimic_nh.param("kp", default_kp, 1e4);
+  mimic_nh.param("kd", default_kd, 200.);
+  const double dt = physicsStepSize(model->GetWorld());
+
+  std::vector<double> multiplier, offset, kp, kd;
+  typedef std::map<std::string, boost::shared_ptr<urdf::Joint> >::const_iterator Iterator;
+  for (Iterator it = urdf_model.joints_.begin(); it != urdf_model.joints_.end(); ++it)
+  {
+    const urdf::Joint& joint = *it->second;
+    if (!joint.mimic)
+    {
+      continue;
+    }
+    gazebo::physics::JointPtr follower = model->GetJoint(joint.name);
+    gazebo::physics::JointPtr leader = model->GetJoint(joint.mimic->joint_name);
+    if (!follower || !leader)
+    {
+      ROS_ERROR_STREAM("Could not find the joints of mimic relation " << joint.name << " -> "
+                                                                      << joint.mimic->joint_name);
+      return false;
+    }
+    followers_.push_back(follower);
+    leaders_.push_back(leader);
+    multiplier.push_back(joint.mimic->multiplier);
+    offset.push_back(joint.mimic->offset);
+
+    ros::NodeHandle joint_nh(mimic_nh, joint.name);
+    const double joint_kp = joint_nh.param("kp", default_kp);
+    const double joint_kd = joint_nh.param("kd", default_kd);
+    const double inertia = joint_nh.param("inertia", childLinkInertia(follower));
+    if (joint_kp < 0. || joint_kd < 0. || inertia <= 0.)
+    {
+      ROS_ERROR_STREAM("Invalid gains or inertia of mimic joint " << joint.name);
+      return false;
+    }
+    if (joint_kd * dt >= 1. || joint_kp * dt * dt >= 1.)
+    {
+      ROS_ERROR_STREAM("Gains of mimic joint " << joint.name << " are unstable with a " << dt
+                                               << " s step, kd must be below " << 1. / dt
+                                               << " and kp below " << 1. / (dt * dt));
+      return false;
+    }
+    kp.push_back(joint_kp * inertia);
+    kd.push_back(joint_kd * inertia);
+    ROS_INFO_STREAM("Parsed mimic joint: " << joint.name << " following "
+                                           << joint.mimic->joint_name);
+  }
+
+  const size_t n = followers_.size();
+  if (n == 0)
+  {
+    enabled_ = false;
+    return true;
+  }
+  multiplier_ = Eigen::Map<Eigen::ArrayXd>(&multiplier[0], n);
+  offset_ = Eigen::Map<Eigen::ArrayXd>(&offset[0], n);
+  kp_ = Eigen::Map<Eigen::ArrayXd>(&kp[0], n);
+  kd_ = Eigen::Map<Eigen::ArrayXd>(&kd[0], n);
+  leaderPosition_.setZero(n);
+  leaderVelocity_.setZero(n);
+  followerPosition_.setZero(n);
+  followerVelocity_.setZero(n);
+  effort_.setZero(n);
+  return true;
+}
+
+void MimicJoints::apply()
+{
+  for (size_t i = 0; i < followers_.size(); ++i)
+  {
+    leaderPosition_(i) = jointPosition(leaders_[i]);
+    leaderVelocity_(i) = leaders_[i]->GetVelocity(0);
+    followerPosition_(i) = jointPosition(followers_[i]);
+    followerVelocity_(i) = followers_[i]->GetVelocity(0);
+  }
+
+  effort_ = kp_ * (multiplier_ * leaderPosition_ + offset_ - followerPosition_) +
+            kd_ * (multiplier_ * leaderVelocity_ - followerVelocity_);
+
+  for (size_t i = 0; i < followers_.size(); ++i)
+  {
+    followers_[i]->SetForce(0, effort_(i));
+    leaders_[i]->SetForce(0, -multiplier_(i) * effort_(i));
+  }
+}
+}
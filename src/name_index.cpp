@@ -0,0 +1,148 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <algorithm>
+#include <set>
+
+#include <pal_hardware_gazebo/name_index.h>
+
+namespace gazebo_ros_control
+{
+namespace
+{
+const uint32_t MAX_SEED = 1u << 16;
+
+struct Bucket
+{
+  size_t index;
+  std::vector<size_t> names;
+
+  bool operator<(const Bucket& other) const
+  {
+    return names.size() > other.names.size();
+  }
+};
+}
+
+NameIndex::NameIndex()
+{
+}
+
+uint64_t NameIndex::hash(const std::string& name, uint64_t seed)
+{
+  // FNV-1a with a seeded offset and a final avalanche step
+  uint64_t h = 14695981039346656037ull ^ (seed * 0x9E3779B97F4A7C15ull);
+  for (size_t i = 0; i < name.size(); ++i)
+  {
+    h ^= static_cast<unsigned char>(name[i]);
+    h *= 1099511628211ull;
+  }
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  return h;
+}
+
+bool NameIndex::build(const std::vector<std::string>& names)
+{
+  if (std::set<std::string>(names.begin(), names.end()).size() != names.size())
+  {
+    return false;
+  }
+  names_ = names;
+  seeds_.clear();
+  slots_.clear();
+  if (names_.empty())
+  {
+    return true;
+  }
+
+  // Grow the table until every bucket finds a seed, the minimal size almost
+  // always works for the few hundred names of a robot
+  for (size_t table_size = names_.size();; table_size += 1 + table_size / 8)
+  {
+    if (tryBuild(table_size))
+    {
+      return true;
+    }
+  }
+}
+
+bool NameIndex::tryBuild(size_t table_size)
+{
+  const size_t bucket_count = std::max<size_t>(1, names_.size() / 2);
+  std::vector<Bucket> buckets(bucket_count);
+  for (size_t b = 0; b < bucket_count; ++b)
+  {
+    buckets[b].index = b;
+  }
+  for (size_t i = 0; i < names_.size(); ++i)
+  {
+    buckets[hash(names_[i], 0) % bucket_count].names.push_back(i);
+  }
+  // Place the largest buckets first, while the table is still empty
+  std::sort(buckets.begin(), buckets.end());
+
+  seeds_.assign(bucket_count, 0);
+  slots_.assign(table_size, -1);
+  std::vector<size_t> candidate;
+  for (size_t b = 0; b < bucket_count; ++b)
+  {
+    const Bucket& bucket = buckets[b];
+    if (bucket.names.empty())
+    {
+      break;
+    }
+
+    uint32_t seed = 1;
+    for (; seed < MAX_SEED; ++seed)
+    {
+      candidate.clear();
+      bool free = true;
+      for (size_t k = 0; k < bucket.names.size() && free; ++k)
+      {
+        const size_t slot = hash(names_[bucket.names[k]], seed) % table_size;
+        free = slots_[slot] < 0 &&
+               std::find(candidate.begin(), candidate.end(), slot) == candidate.end();
+        candidate.push_back(slot);
+      }
+      if (free)
+      {
+        break;
+      }
+    }
+    if (seed == MAX_SEED)
+    {
+      return false;
+    }
+
+    seeds_[bucket.index] = seed;
+    for (size_t k = 0; k < bucket.names.size(); ++k)
+    {
+      slots_[candidate[k]] = bucket.names[k];
+    }
+  }
+  return true;
+}
+
+int NameIndex::find(const std::string& name) const
+{
+  if (names_.empty())
+  {
+    return -1;
+  }
+  const uint32_t seed = seeds_[hash(name, 0) % seeds_.size()];
+  if (seed == 0)
+  {
+    return -1;
+  }
+  const int index = slots_[hash(name, seed) % slots_.size()];
+  return index >= 0 && names_[index] == name ? index : -1;
+}
+}
@@ -25,10 +25,13 @@
 // POSSIBILITY OF SUCH DAMAGE.
 //////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
 #include <cassert>
+#include <boost/bind.hpp>
 #include <boost/foreach.hpp>
 
 #include <gazebo/sensors/SensorManager.hh>
+#include <sdf/sdf.hh>
 
 #include <urdf_parser/urdf_parser.h>
 #include <pluginlib/class_list_macros.h>
@@ -151,6 +154,74 @@ Eigen::Matrix<T, 3, 3> skew(const Eigen::Matrix<T, 3, 1>& vec)
       .finished();
 }
 
+/// Rotation, signed by the measure direction, from the frame an SDF force-torque sensor measures
+/// in to the child link of its joint, where the joint wrench is computed from the child to the
+/// parent. False if the sensor measures in the parent link, whose orientation relative to the
+/// child link follows the joint position.
+bool sdfMeasureToChild(const gazebo::sensors::ForceTorqueSensorPtr& sensor,
+                       const gazebo::physics::JointPtr& joint, eMatrixRot& to_child)
+{
+  sdf::ElementPtr joint_sdf = joint->GetSDF();
+  sdf::ElementPtr sensor_sdf;
+  if (joint_sdf && joint_sdf->HasElement("sensor"))
+  {
+    sensor_sdf = joint_sdf->GetElement("sensor");
+  }
+  while (sensor_sdf && sensor_sdf->Get<std::string>("name") != sensor->Name())
+  {
+    sensor_sdf = sensor_sdf->GetNextElement("sensor");
+  }
+  if (!sensor_sdf)
+  {
+    return false;
+  }
+
+  // SDF defaults
+  std::string frame = "child";
+  std::string direction = "child_to_parent";
+  if (sensor_sdf->HasElement("force_torque"))
+  {
+    sdf::ElementPtr ft_sdf = sensor_sdf->GetElement("force_torque");
+    if (ft_sdf->HasElement("frame"))
+    {
+      frame = ft_sdf->Get<std::string>("frame");
+    }
+    if (ft_sdf->HasElement("measure_direction"))
+    {
+      direction = ft_sdf->Get<std::string>("measure_direction");
+    }
+  }
+  if (direction != "child_to_parent" && direction != "parent_to_child")
+  {
+    return false;
+  }
+
+  if (frame == "child")
+  {
+    to_child.setIdentity();
+  }
+  else if (frame == "sensor")
+  {
+    // The sensor pose is relative to the joint, itself relative to the child link
+#if GAZEBO_MAJOR_VERSION >= 8
+    const ignition::math::Quaterniond rot = (sensor->Pose() + joint->InitialAnchorPose()).Rot();
+#else
+    const ignition::math::Quaterniond rot =
+        (sensor->Pose() + joint->GetInitialAnchorPose().Ign()).Rot();
+#endif
+    to_child = eQuaternion(rot.W(), rot.X(), rot.Y(), rot.Z()).toRotationMatrix();
+  }
+  else
+  {
+    return false;
+  }
+  if (direction == "parent_to_child")
+  {
+    to_child = -to_child;
+  }
+  return true;
+}
+
 namespace gazebo_ros_control
 {
 using namespace hardware_interface;
@@ -254,6 +325,116 @@ bool PalHardwareGazebo::parseForceTorqueSensors(ros::NodeHandle& nh,
   return true;
 }
 
+void PalHardwareGazebo::discoverForceTorqueSensors(ros::NodeHandle& nh,
+                                                   gazebo::physics::ModelPtr model)
+{
+  ros::NodeHandle discovery_nh(nh, "force_torque_discovery");
+  std::string mode;
+  discovery_nh.param<std::string>("mode", mode, "report");
+  if (mode != "report" && mode != "disable" && mode != "consume")
+  {
+    ROS_WARN_STREAM("Unknown force_torque_discovery mode '" << mode
+                                                             << "', falling back to 'report'.");
+    mode = "report";
+  }
+
+  const gazebo::physics::Joint_V& joints = model->GetJoints();
+  gazebo::sensors::Sensor_V sensors = gazebo::sensors::SensorManager::Instance()->GetSensors();
+  for (size_t i = 0; i < sensors.size(); ++i)
+  {
+    gazebo::sensors::ForceTorqueSensorPtr sdf_ft =
+        std::dynamic_pointer_cast<gazebo::sensors::ForceTorqueSensor>(sensors[i]);
+    if (!sdf_ft)
+    {
+      continue;
+    }
+    gazebo::physics::JointPtr joint = sdf_ft->Joint();
+    if (!joint || std::find(joints.begin(), joints.end(), joint) == joints.end())
+    {
+      continue;  // Sensor of another model
+    }
+
+    ForceTorqueSensorDefinitionPtr duplicate;
+    for (size_t j = 0; j < forceTorqueSensorDefinitions_.size(); ++j)
+    {
+      if (forceTorqueSensorDefinitions_[j]->gazebo_joint == joint)
+      {
+        duplicate = forceTorqueSensorDefinitions_[j];
+        break;
+      }
+    }
+
+    if (!duplicate)
+    {
+      bool name_taken = false;
+      for (size_t j = 0; j < forceTorqueSensorDefinitions_.size(); ++j)
+      {
+        name_taken = name_taken || forceTorqueSensorDefinitions_[j]->sensorName == sdf_ft->Name();
+      }
+      if (mode != "consume" || name_taken)
+      {
+        ROS_INFO_STREAM("Found SDF force-torque sensor '"
+                        << sdf_ft->ScopedName() << "' on joint '" << joint->GetName()
+                        << "', not exposed as a hardware interface.");
+        continue;
+      }
+
+      // Expose it like a parsed sensor, reporting in the child link frame
+      ForceTorqueSensorDefinitionPtr ft(new ForceTorqueSensorDefinition(
+          sdf_ft->Name(), joint->GetName(), joint->GetChild()->GetName()));
+      ft->gazebo_joint = joint;
+      ft->sensorTransform.setIdentity();
+      if (sdfMeasureToChild(sdf_ft, joint, ft->sdfToChild))
+      {
+        ft->gazebo_ft_sensor = sdf_ft;
+      }
+      else
+      {
+        ROS_WARN_STREAM("SDF force-torque sensor '"
+                        << sdf_ft->ScopedName()
+                        << "' measures in a frame that can not be related to the child link of "
+                           "its joint, computing its wrench instead.");
+      }
+      forceTorqueSensorDefinitions_.push_back(ft);
+      ROS_INFO_STREAM("Discovered SDF force-torque sensor: " << ft->sensorName << " on joint: "
+                                                             << ft->sensorJointName);
+      continue;
+    }
+
+    if (mode == "disable")
+    {
+      sdf_ft->SetActive(false);
+      ROS_WARN_STREAM("FT sensor '" << duplicate->sensorName << "' duplicates SDF sensor '"
+                                    << sdf_ft->ScopedName() << "' on joint '"
+                                    << joint->GetName() << "', disabled the SDF sensor.");
+    }
+    else if (mode == "consume" && sdfMeasureToChild(sdf_ft, joint, duplicate->sdfToChild))
+    {
+      // Still transformed to the frame of the parsed sensor
+      duplicate->gazebo_ft_sensor = sdf_ft;
+      ROS_WARN_STREAM("FT sensor '" << duplicate->sensorName << "' duplicates SDF sensor '"
+                                    << sdf_ft->ScopedName() << "' on joint '"
+                                    << joint->GetName() << "', reading the SDF sensor output.");
+    }
+    else if (mode == "consume")
+    {
+      ROS_WARN_STREAM("FT sensor '" << duplicate->sensorName << "' duplicates SDF sensor '"
+                                    << sdf_ft->ScopedName() << "' on joint '"
+                                    << joint->GetName()
+                                    << "', whose measure frame can not be related to the "
+                                       "child link of the joint, computing the wrench instead.");
+    }
+    else
+    {
+      ROS_WARN_STREAM("FT sensor '" << duplicate->sensorName << "' duplicates SDF sensor '"
+                                    << sdf_ft->ScopedName() << "' on joint '"
+                                    << joint->GetName()
+                                    << "', the wrench is computed twice per tick. Set "
+                                       "force_torque_discovery/mode to 'disable' or 'consume'.");
+    }
+  }
+}
+
 bool PalHardwareGazebo::parseIMUSensors(ros::NodeHandle& nh, gazebo::physics::ModelPtr model,
                                         const urdf::Model* const urdf_model)
 {
@@ -296,140 +477,1376 @@ bool PalHardwareGazebo::parseIMUSensors(ros::NodeHandle& nh, gazebo::physics::Mo
   return true;
 }
 
-PalHardwareGazebo::PalHardwareGazebo() : DefaultRobotHWSim()
+bool PalHardwareGazebo::parseJointGroups(ros::NodeHandle& nh)
 {
+  const string groups_ns = "joint_groups";
+  vector<string> group_ids = getIds(nh, groups_ns);
+  ros::NodeHandle groups_nh(nh, groups_ns);
+  for (size_t i = 0; i < group_ids.size(); ++i)
+  {
+    const std::string& group_name = group_ids[i];
+    vector<string> joint_names;
+    if (!groups_nh.getParam(group_name + "/joints", joint_names))
+    {
+      ROS_ERROR_STREAM("Could not load the joints of joint group " << group_name);
+      return false;
+    }
+
+    // Commands are written through a single interface, the one the controllers claim
+    string interface;
+    groups_nh.param<string>(group_name + "/interface", interface, "");
+    const char* interfaces[] = { "", "position", "velocity", "effort" };
+    JointBuffers::CommandType command_type = JointBuffers::NO_COMMAND;
+    for (size_t t = JointBuffers::POSITION_COMMAND; t <= JointBuffers::EFFORT_COMMAND; ++t)
+    {
+      if (interface == interfaces[t])
+      {
+        command_type = static_cast<JointBuffers::CommandType>(t);
+      }
+    }
+    if (command_type == JointBuffers::NO_COMMAND)
+    {
+      ROS_ERROR_STREAM("Joint group " << group_name
+                                      << " needs an interface: position, velocity or effort");
+      return false;
+    }
+
+    JointGroupPtr group(new JointGroup());
+    if (!group->init(group_name, joint_names, command_type, jointBuffers_))
+    {
+      return false;
+    }
+    controllerClaims_.addGroup(group_name, group->getIndices());
+    joint_group_interface_.registerHandle(JointGroupHandle(group->getHandleData()));
+    jointGroups_.push_back(group);
+    ROS_INFO_STREAM("Parsed joint group: " << group_name << " with " << joint_names.size()
+                                           << " " << interface << " joints");
+  }
+
+  registerInterface(&joint_group_interface_);
+  return true;
 }
 
-bool PalHardwareGazebo::initSim(const std::string& robot_ns, ros::NodeHandle nh,
-                                gazebo::physics::ModelPtr model,
-                                const urdf::Model* const urdf_model,
-                                std::vector<transmission_interface::TransmissionInfo> transmissions)
+bool PalHardwareGazebo::registerNameIndices()
 {
-  ROS_INFO_STREAM("Loading PAL HARWARE GAZEBO");
-
-  if (!DefaultRobotHWSim::initSim(robot_ns, nh, model, urdf_model, transmissions))
+  vector<string> ft_names;
+  for (size_t i = 0; i < forceTorqueSensorDefinitions_.size(); ++i)
+  {
+    ft_names.push_back(forceTorqueSensorDefinitions_[i]->sensorName);
+  }
+  vector<string> imu_names;
+  for (size_t i = 0; i < imuSensorDefinitions_.size(); ++i)
   {
+    imu_names.push_back(imuSensorDefinitions_[i]->sensorName);
+  }
+  if (!forceTorqueSensorIndex_.build(ft_names) || !imuSensorIndex_.build(imu_names))
+  {
+    ROS_ERROR_STREAM("Sensor names must be unique");
     return false;
   }
 
-  parseForceTorqueSensors(nh, model, urdf_model);
+  name_index_interface_.registerHandle(NameIndexHandle("joints", &jointBuffers_.nameIndex()));
+  name_index_interface_.registerHandle(
+      NameIndexHandle("force_torque_sensors", &forceTorqueSensorIndex_));
+  name_index_interface_.registerHandle(NameIndexHandle("imu_sensors", &imuSensorIndex_));
+  name_index_interface_.registerHandle(
+      NameIndexHandle("joint_groups", &controllerClaims_.groupIndex()));
+  registerInterface(&name_index_interface_);
+  return true;
+}
 
-  for (size_t i = 0; i < forceTorqueSensorDefinitions_.size(); ++i)
+namespace
+{
+/// Suffixes of the command channels, by command type
+const char* const COMMAND_CHANNEL_TYPES[] = { "", "position_command", "velocity_command",
+                                              "effort_command" };
+
+/// Adds resources to the claims of an interface, merging with an existing entry
+template <class Resources>
+void addClaims(std::vector<InterfaceResources>& claims, const std::string& interface,
+               const Resources& resources)
+{
+  for (size_t i = 0; i < claims.size(); ++i)
   {
-    ForceTorqueSensorDefinitionPtr& ft = forceTorqueSensorDefinitions_[i];
-    ft_sensor_interface_.registerHandle(ForceTorqueSensorHandle(
-        ft->sensorName, ft->sensorFrame, &ft->force[0], &ft->torque[0]));
+    if (claims[i].hardware_interface == interface)
+    {
+      claims[i].resources.insert(resources.begin(), resources.end());
+      return;
+    }
   }
+  InterfaceResources claim;
+  claim.hardware_interface = interface;
+  claim.resources.insert(resources.begin(), resources.end());
+  claims.push_back(claim);
+}
+}
 
-  registerInterface(&ft_sensor_interface_);
-  ROS_DEBUG_STREAM("Registered force-torque sensors.");
+void PalHardwareGazebo::collectCommandChannels(std::vector<double*>& commands,
+                                               std::vector<std::string>& names) const
+{
+  for (size_t i = 0; i < jointBuffers_.size(); ++i)
+  {
+    for (size_t t = JointBuffers::POSITION_COMMAND; t <= JointBuffers::EFFORT_COMMAND; ++t)
+    {
+      double* command = jointBuffers_.commandFor(i, static_cast<JointBuffers::CommandType>(t));
+      if (command)
+      {
+        commands.push_back(command);
+        names.push_back(jointBuffers_.names[i] + "/" + COMMAND_CHANNEL_TYPES[t]);
+      }
+    }
+  }
+}
 
-  // Hardware interfaces: Base IMU sensors
-  parseIMUSensors(nh, model, urdf_model);
+bool PalHardwareGazebo::initControllerHost(ros::NodeHandle& nh, const std::string& robot_ns)
+{
+  bool enabled;
+  nh.param("controller_host/enabled", enabled, false);
+  vector<double*> commands, driven_commands;
+  vector<string> command_names, driven;
+  collectCommandChannels(commands, command_names);
+
+  // By default the controller process drives every joint through its first interface
+  if (enabled && !nh.getParam("controller_host/commands", driven))
+  {
+    for (size_t i = 0; i < jointBuffers_.size(); ++i)
+    {
+      if (jointBuffers_.command[i])
+      {
+        driven.push_back(jointBuffers_.names[i] + "/" +
+                         COMMAND_CHANNEL_TYPES[jointBuffers_.commandType[i]]);
+      }
+    }
+  }
+  for (size_t i = 0; i < driven.size(); ++i)
+  {
+    const vector<string>::const_iterator it =
+        std::find(command_names.begin(), command_names.end(), driven[i]);
+    if (it == command_names.end())
+    {
+      ROS_ERROR_STREAM("Unknown command channel " << driven[i] << " in controller_host/commands");
+      return false;
+    }
+    driven_commands.push_back(commands[it - command_names.begin()]);
+  }
 
-  for (size_t i = 0; i < imuSensorDefinitions_.size(); ++i)
+  string default_name = robot_ns;
+  std::replace(default_name.begin(), default_name.end(), '/', '_');
+  if (!controllerHost_.init(nh, "/" + default_name + "_controller_host", sensorChannels_,
+                            sensorChannelNames_, driven_commands, driven))
   {
-    ImuSensorDefinitionPtr& imu = imuSensorDefinitions_[i];
+    return false;
+  }
+  return !controllerHost_.enabled() ||
+         reserveCommandChannels("pal_hardware_gazebo/controller_host", driven);
+}
 
-    ImuSensorHandle::Data data;
-    data.name = imu->sensorName;
-    data.frame_id = imu->sensorFrame;
-    data.orientation = &imu->orientation[0];
-    data.linear_acceleration = &imu->linear_acceleration[0];
-    data.angular_velocity = &imu->base_ang_vel[0];
-    imu_sensor_interface_.registerHandle(ImuSensorHandle(data));
+void PalHardwareGazebo::collectObservationChannels(std::vector<double*>& channels,
+                                                   std::vector<std::string>& names)
+{
+  channels = sensorChannels_;
+  names = sensorChannelNames_;
+  floatingBaseState_.addChannels(names, channels);
+}
+
+bool PalHardwareGazebo::initPolicy(ros::NodeHandle& nh)
+{
+  vector<double*> commands, channels;
+  vector<string> command_names, channel_names;
+  collectCommandChannels(commands, command_names);
+  collectObservationChannels(channels, channel_names);
+
+  if (!policyHook_.init(nh, channel_names, channels, command_names, commands))
+  {
+    return false;
+  }
+  if (policyHook_.enabled() && FloatingBaseState::uses(policyHook_.observationLayout().names()))
+  {
+    floatingBaseStateUsed_ = true;
   }
+  return !policyHook_.enabled() ||
+         reserveCommandChannels("pal_hardware_gazebo/policy", policyHook_.actionLayout().names());
+}
 
-  registerInterface(&imu_sensor_interface_);
-  ROS_DEBUG_STREAM("Registered IMU sensor.");
+bool PalHardwareGazebo::reserveCommandChannels(const std::string& owner,
+                                               const std::vector<std::string>& channels)
+{
+  ControllerInfo info;
+  info.name = owner;
+  for (size_t i = 0; i < channels.size(); ++i)
+  {
+    const string& channel = channels[i];
+    const size_t slash = channel.rfind('/');
+    JointBuffers::CommandType type = JointBuffers::NO_COMMAND;
+    for (size_t t = JointBuffers::POSITION_COMMAND; t <= JointBuffers::EFFORT_COMMAND; ++t)
+    {
+      if (slash != string::npos && channel.compare(slash + 1, string::npos,
+                                                   COMMAND_CHANNEL_TYPES[t]) == 0)
+      {
+        type = static_cast<JointBuffers::CommandType>(t);
+      }
+    }
+    if (type == JointBuffers::NO_COMMAND)
+    {
+      ROS_ERROR_STREAM("Command channel " << channel << " of " << owner << " names no joint");
+      return false;
+    }
+    const string joint = channel.substr(0, slash);
+    const string interface = JointBuffers::interfaceName(type);
+    for (size_t c = 0; c < info.claimed_resources.size(); ++c)
+    {
+      if (info.claimed_resources[c].resources.count(joint) &&
+          info.claimed_resources[c].hardware_interface != interface)
+      {
+        ROS_ERROR_STREAM(owner << " commands joint " << joint << " through two interfaces");
+        return false;
+      }
+    }
+    addClaims(info.claimed_resources, interface, std::vector<string>(1, joint));
+  }
 
+  // Conflicts with the joints reserved before
+  std::string resource;
+  if (controllerClaims_.findConflict(std::list<ControllerInfo>(1, info), resource))
+  {
+    ROS_ERROR_STREAM(owner << " commands joint " << resource << " which is already written");
+    return false;
+  }
+  controllerClaims_.reserve(info);
+  reservedClaims_.push_back(info);
   return true;
 }
 
-void PalHardwareGazebo::readSim(ros::Time time, ros::Duration period)
+bool PalHardwareGazebo::initBatchedStep(ros::NodeHandle& nh, gazebo::physics::ModelPtr model)
 {
-  // read all resources
-  BOOST_FOREACH (RwResPtr res, rw_resources_)
+  bool enabled;
+  nh.param("batched_step/enabled", enabled, false);
+  if (!enabled)
   {
-    res->read(time, period, e_stop_active_);
+    return true;
   }
 
-  // Read force-torque sensors
-  for (size_t i = 0; i < forceTorqueSensorDefinitions_.size(); ++i)
+  vector<double*> commands, channels;
+  vector<string> command_names, channel_names;
+  collectCommandChannels(commands, command_names);
+  collectObservationChannels(channels, channel_names);
+
+  vector<string> observations, actions;
+  nh.getParam("batched_step/observations", observations);
+  nh.getParam("batched_step/actions", actions);
+  if (!batchObservationLayout_.init(observations, channel_names, channels) ||
+      !batchActionLayout_.init(actions, command_names, commands))
   {
-    ForceTorqueSensorDefinitionPtr& ft = forceTorqueSensorDefinitions_[i];
-    gazebo::physics::JointWrench ft_wrench = ft->gazebo_joint->GetForceTorque(0u);
-
-    #if GAZEBO_MAJOR_VERSION < 8
-      ft->force[0] = ft_wrench.body2Force.x;
-      ft->force[1] = ft_wrench.body2Force.y;
-      ft->force[2] = ft_wrench.body2Force.z;
-      ft->torque[0] = ft_wrench.body2Torque.x;
-      ft->torque[1] = ft_wrench.body2Torque.y;
-      ft->torque[2] = ft_wrench.body2Torque.z;
-    #else
-      ft->force[0] = ft_wrench.body2Force.X();
-      ft->force[1] = ft_wrench.body2Force.Y();
-      ft->force[2] = ft_wrench.body2Force.Z();
-      ft->torque[0] = ft_wrench.body2Torque.X();
-      ft->torque[1] = ft_wrench.body2Torque.Y();
-      ft->torque[2] = ft_wrench.body2Torque.Z();
-    #endif
+    return false;
+  }
+  if (FloatingBaseState::uses(observations))
+  {
+    floatingBaseStateUsed_ = true;
+  }
 
-    // Transform to sensor frame
-    Eigen::MatrixXd transform(6, 6);
-    transform.setZero();
-    transform.block(0, 0, 3, 3) = Eigen::Matrix3d::Identity();
-    transform.block(3, 3, 3, 3) = ft->sensorTransform.rotation().transpose();
-    eVector3 r = ft->sensorTransform.translation();
-    transform.block(3, 0, 3, 3) = skew(r) * ft->sensorTransform.rotation().transpose();
+  if (!reserveCommandChannels("pal_hardware_gazebo/batched_step", actions))
+  {
+    return false;
+  }
 
-    Eigen::VectorXd wrench(6);
-    wrench << ft->torque[0], ft->torque[1], ft->torque[2], ft->force[0], ft->force[1],
-        ft->force[2];
-    Eigen::VectorXd transformedWrench(6);
+  batchedEnvironment_ = BatchedEnvironment::forWorld(model->GetWorld());
+  batchedSlot_ = batchedEnvironment_->addRobot(
+      model->GetName(), batchObservationLayout_.size(), batchActionLayout_.size(),
+      boost::bind(&PalHardwareGazebo::refreshBatchObservation, this, _1));
+  // Start from the current commands rather than zeros
+  batchActionLayout_.gather(batchedEnvironment_->robotAction(batchedSlot_));
+  return true;
+}
 
-    transformedWrench = transform * wrench;
+bool PalHardwareGazebo::initCoSimulation(ros::NodeHandle& nh, const std::string& robot_ns)
+{
+  vector<double*> commands;
+  vector<string> command_names;
+  collectCommandChannels(commands, command_names);
+
+  // The commands sent are the ones of the previous tick, the partner answers this one
+  vector<double*> channels = sensorChannels_;
+  vector<string> channel_names = sensorChannelNames_;
+  channels.insert(channels.end(), commands.begin(), commands.end());
+  channel_names.insert(channel_names.end(), command_names.begin(), command_names.end());
+
+  string default_name = robot_ns;
+  std::replace(default_name.begin(), default_name.end(), '/', '_');
+  return coSimulation_.init(nh, "/" + default_name + "_co_simulation", channel_names, channels,
+                            command_names, commands);
+}
 
-    ft->torque[0] = transformedWrench(0);
-    ft->torque[1] = transformedWrench(1);
-    ft->torque[2] = transformedWrench(2);
-    ft->force[0] = transformedWrench(3);
-    ft->force[1] = transformedWrench(4);
-    ft->force[2] = transformedWrench(5);
-  }
+const PalHardwareGazebo::RwResources& PalHardwareGazebo::writtenResources() const
+{
+  // Includes the joints reserved by the controller host, policy and batched step
+  return active_w_resources_rt_;
+}
 
-  // Read IMU sensor
-  for (size_t i = 0; i < imuSensorDefinitions_.size(); ++i)
+std::vector<std::string> PalHardwareGazebo::activeResourceNames() const
+{
+  vector<string> names;
+  const RwResources& resources = writtenResources();
+  for (size_t i = 0; i < resources.size(); ++i)
   {
-    ImuSensorDefinitionPtr& imu = imuSensorDefinitions_[i];
+    names.push_back(resources[i]->getName());
+  }
+  return names;
+}
 
-    gazebo::math::Quaternion imu_quat = imu->gazebo_imu_sensor->Orientation();
-    imu->orientation[0] = imu_quat.x;
-    imu->orientation[1] = imu_quat.y;
-    imu->orientation[2] = imu_quat.z;
-    imu->orientation[3] = imu_quat.w;
+std::vector<std::string> PalHardwareGazebo::resourceNames() const
+{
+  vector<string> names;
+  for (size_t i = 0; i < rw_resources_.size(); ++i)
+  {
+    names.push_back(rw_resources_[i]->getName());
+  }
+  return names;
+}
 
-    gazebo::math::Vector3 imu_ang_vel = imu->gazebo_imu_sensor->AngularVelocity();
-    imu->base_ang_vel[0] = imu_ang_vel.x;
-    imu->base_ang_vel[1] = imu_ang_vel.y;
-    imu->base_ang_vel[2] = imu_ang_vel.z;
+bool PalHardwareGazebo::initMobileBase(ros::NodeHandle& nh, gazebo::physics::ModelPtr model)
+{
+  if (!nh.hasParam("mobile_base"))
+  {
+    return true;
+  }
+  if (!diffDriveGeometry_.init(nh, jointBuffers_) ||
+      !kinematicBase_.init(nh, diffDriveGeometry_, jointBuffers_, model))
+  {
+    return false;
+  }
+  if (kinematicBase_.enabled())
+  {
+    kinematicBase_.setResources(resourceNames());
+    kinematicBase_.setActiveResources(activeResourceNames());
+  }
 
-    gazebo::math::Vector3 imu_lin_acc = imu->gazebo_imu_sensor->LinearAcceleration();
-    imu->linear_acceleration[0] = imu_lin_acc.x;
-    imu->linear_acceleration[1] = imu_lin_acc.y;
-    imu->linear_acceleration[2] = imu_lin_acc.z;
+  if (!wheelOdometry_.init(nh, diffDriveGeometry_, jointBuffers_))
+  {
+    return false;
+  }
+  if (wheelOdometry_.enabled())
+  {
+    odometry_interface_.registerHandle(OdometryHandle(wheelOdometry_.getHandleData("odometry")));
+    registerInterface(&odometry_interface_);
+    ROS_DEBUG_STREAM("Registered wheel odometry.");
   }
+  return true;
 }
 
-void PalHardwareGazebo::writeSim(ros::Time time, ros::Duration period)
+bool PalHardwareGazebo::initSensorHealth(ros::NodeHandle& nh)
 {
-  boost::unique_lock<boost::mutex> lock(mutex_);
-  BOOST_FOREACH (RwResPtr res, active_w_resources_rt_)
+  // Simulated joints are legitimately still, only the sensors are checked for staleness
+  vector<string> stale_prefixes;
+  for (size_t i = 0; i < forceTorqueSensorDefinitions_.size(); ++i)
+  {
+    stale_prefixes.push_back(forceTorqueSensorDefinitions_[i]->sensorName + "/");
+  }
+  for (size_t i = 0; i < imuSensorDefinitions_.size(); ++i)
+  {
+    stale_prefixes.push_back(imuSensorDefinitions_[i]->sensorName + "/");
+  }
+
+  if (!sensorHealth_.init(nh, sensorChannelNames_, sensorChannels_, stale_prefixes))
+  {
+    return false;
+  }
+  if (sensorHealth_.enabled())
+  {
+    sensorHealth_.registerHandles(sensor_health_interface_);
+    registerInterface(&sensor_health_interface_);
+  }
+  return true;
+}
+
+bool PalHardwareGazebo::initLoadShedding(ros::NodeHandle& nh)
+{
+  if (!loadShedder_.init(nh))
+  {
+    return false;
+  }
+  if (!loadShedder_.enabled())
+  {
+    return true;
+  }
+
+  // Shed first, restored last
+  loadShedder_.addTask("introspection publishing",
+                       boost::bind(&PalHardwareGazebo::setIntrospectionFactor, this, _1));
+  if (columnarExporter_.enabled())
+  {
+    loadShedder_.addTask("columnar export", boost::bind(&BufferedSignalWriter::setDecimationFactor,
+                                                        &columnarExporter_, _1));
+  }
+  if (sensorStreamRecorder_.enabled())
+  {
+    loadShedder_.addTask("sensor recording", boost::bind(&BufferedSignalWriter::setDecimationFactor,
+                                                         &sensorStreamRecorder_, _1));
+  }
+  if (wheelOdometry_.enabled())
+  {
+    loadShedder_.addTask("odometry publishing",
+                         boost::bind(&WheelOdometry::setPublishFactor, &wheelOdometry_, _1));
+  }
+  if (lazyJointReader_.enabled())
+  {
+    loadShedder_.addTask("background joint reads",
+                         boost::bind(&LazyJointReader::setBackgroundFactor, &lazyJointReader_, _1));
+  }
+  return true;
+}
+
+bool PalHardwareGazebo::initMetrics(ros::NodeHandle& nh, const std::string& robot_ns)
+{
+  vector<string> sensor_names;
+  if (sensorHealth_.enabled())
+  {
+    for (size_t i = 0; i < sensorHealth_.sensorCount(); ++i)
+    {
+      sensor_names.push_back(sensorHealth_.sensorName(i));
+    }
+  }
+  return metrics_.init(nh, robot_ns, sensor_names);
+}
+
+void PalHardwareGazebo::setIntrospectionFactor(unsigned int factor)
+{
+  introspectionFactor_ = factor;
+}
+
+void PalHardwareGazebo::registerIntrospection(ros::NodeHandle& nh)
+{
+  bool enabled;
+  nh.param("introspection/register_hardware", enabled, true);
+  if (!enabled)
+  {
+    return;
+  }
+
+  // The published snapshot reads the buffers in place, nothing is copied per tick here
+  for (size_t i = 0; i < sensorChannels_.size(); ++i)
+  {
+    REGISTER_VARIABLE(sensorChannels_[i], "hardware/" + sensorChannelNames_[i],
+                      registeredVariables_);
+  }
+  vector<double*> commands;
+  vector<string> command_names;
+  collectCommandChannels(commands, command_names);
+  for (size_t i = 0; i < commands.size(); ++i)
+  {
+    REGISTER_VARIABLE(commands[i], "hardware/" + command_names[i], registeredVariables_);
+  }
+  ROS_INFO_STREAM("Registered " << registeredVariables_.size()
+                                << " hardware variables for introspection.");
+}
+
+void PalHardwareGazebo::initScheduling(ros::NodeHandle& nh, gazebo::physics::ModelPtr model)
+{
+  bool enabled;
+  nh.param("parallel_scheduling/enabled", enabled, false);
+  if (!enabled)
+  {
+    return;
+  }
+  int threads;
+  nh.param("parallel_scheduling/threads", threads,
+           std::max(static_cast<int>(boost::thread::hardware_concurrency()) - 1, 0));
+
+#if GAZEBO_MAJOR_VERSION >= 8
+  const std::string world_name = model->GetWorld()->Name();
+#else
+  const std::string world_name = model->GetWorld()->GetName();
+#endif
+  scheduler_ = HardwareScheduler::forWorld(world_name, std::max(threads, 0));
+  scheduler_->add(this);
+}
+
+bool PalHardwareGazebo::initLazyRead(ros::NodeHandle& nh)
+{
+  if (!lazyJointReader_.init(nh, jointBuffers_))
+  {
+    return false;
+  }
+  if (!lazyJointReader_.enabled())
+  {
+    return true;
+  }
+
+  // Joints consumed by the plugin itself are read on every tick. The sensor
+  // delay line pushes every channel on every tick, a joint left unread would
+  // push back its own delayed value
+  if (columnarExporter_.enabled() || sensorStreamRecorder_.enabled() ||
+      controllerHost_.enabled() || coSimulation_.enabled() || policyHook_.enabled() ||
+      batchedEnvironment_ || hardwareEmulation_.delaysSensors())
+  {
+    lazyJointReader_.addAllConsumed();
+  }
+  for (size_t i = 0; i < jointGroups_.size(); ++i)
+  {
+    const std::vector<size_t>& indices = jointGroups_[i]->getIndices();
+    for (size_t j = 0; j < indices.size(); ++j)
+    {
+      lazyJointReader_.addConsumed(indices[j]);
+    }
+  }
+  if (wheelOdometry_.enabled())
+  {
+    for (size_t i = 0; i < diffDriveGeometry_.leftWheels.size(); ++i)
+    {
+      lazyJointReader_.addConsumed(diffDriveGeometry_.leftWheels[i]);
+    }
+    for (size_t i = 0; i < diffDriveGeometry_.rightWheels.size(); ++i)
+    {
+      lazyJointReader_.addConsumed(diffDriveGeometry_.rightWheels[i]);
+    }
+  }
+  const std::vector<size_t> finger_joints = graspManager_.fingerJoints();
+  for (size_t i = 0; i < finger_joints.size(); ++i)
+  {
+    lazyJointReader_.addConsumed(finger_joints[i]);
+  }
+  if (jointSpaceDynamicsEnabled_)
+  {
+    const std::vector<std::string>& names = jointSpaceDynamics_.getJointNames();
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+      lazyJointReader_.addConsumed(jointBuffers_.index(names[i]));
+    }
+  }
+
+  lazyJointReader_.setResources(resourceNames());
+  lazyJointReader_.update(controllerClaims_.active());
+
+  lazyJointReader_.registerHandles(joint_read_request_interface_);
+  registerInterface(&joint_read_request_interface_);
+  return true;
+}
+
+void PalHardwareGazebo::addSensorChannel(const std::string& name, double* value)
+{
+  sensorChannelNames_.push_back(name);
+  sensorChannels_.push_back(value);
+}
+
+void PalHardwareGazebo::collectSensorChannels()
+{
+  const char* axes[] = { "x", "y", "z", "w" };
+
+  sensorChannels_.clear();
+  sensorChannelNames_.clear();
+  for (size_t i = 0; i < jointBuffers_.size(); ++i)
+  {
+    const std::string& name = jointBuffers_.names[i];
+    addSensorChannel(name + "/position", jointBuffers_.position[i]);
+    addSensorChannel(name + "/velocity", jointBuffers_.velocity[i]);
+    addSensorChannel(name + "/effort", jointBuffers_.effort[i]);
+  }
+  for (size_t i = 0; i < forceTorqueSensorDefinitions_.size(); ++i)
+  {
+    ForceTorqueSensorDefinitionPtr& ft = forceTorqueSensorDefinitions_[i];
+    for (size_t j = 0; j < 3; ++j)
+    {
+      addSensorChannel(ft->sensorName + "/force_" + axes[j], &ft->force[j]);
+    }
+    for (size_t j = 0; j < 3; ++j)
+    {
+      addSensorChannel(ft->sensorName + "/torque_" + axes[j], &ft->torque[j]);
+    }
+  }
+  for (size_t i = 0; i < imuSensorDefinitions_.size(); ++i)
+  {
+    ImuSensorDefinitionPtr& imu = imuSensorDefinitions_[i];
+    for (size_t j = 0; j < 4; ++j)
+    {
+      addSensorChannel(imu->sensorName + "/orientation_" + axes[j], &imu->orientation[j]);
+    }
+    for (size_t j = 0; j < 3; ++j)
+    {
+      addSensorChannel(imu->sensorName + "/angular_velocity_" + axes[j], &imu->base_ang_vel[j]);
+    }
+    for (size_t j = 0; j < 3; ++j)
+    {
+      addSensorChannel(imu->sensorName + "/linear_acceleration_" + axes[j],
+                       &imu->linear_acceleration[j]);
+    }
+  }
+}
+
+bool PalHardwareGazebo::initColumnarExport(ros::NodeHandle& nh)
+{
+  if (!columnarExporter_.configure(nh))
+  {
+    return false;
+  }
+  if (!columnarExporter_.enabled())
+  {
+    return true;
+  }
+
+  for (size_t i = 0; i < sensorChannels_.size(); ++i)
+  {
+    columnarExporter_.addSignal(sensorChannelNames_[i], sensorChannels_[i]);
+  }
+  vector<double*> commands;
+  vector<string> command_names;
+  collectCommandChannels(commands, command_names);
+  for (size_t i = 0; i < commands.size(); ++i)
+  {
+    columnarExporter_.addSignal(command_names[i], commands[i]);
+  }
+  return columnarExporter_.start();
+}
+
+bool PalHardwareGazebo::initSensorRecording(ros::NodeHandle& nh)
+{
+  if (!sensorStreamRecorder_.configure(nh))
+  {
+    return false;
+  }
+  if (!sensorStreamRecorder_.enabled())
+  {
+    return true;
+  }
+
+  for (size_t i = 0; i < sensorChannels_.size(); ++i)
+  {
+    sensorStreamRecorder_.addSignal(sensorChannelNames_[i], sensorChannels_[i]);
+  }
+  return sensorStreamRecorder_.start();
+}
+
+bool PalHardwareGazebo::initJointSpaceDynamics(ros::NodeHandle& nh,
+                                               const urdf::Model* const urdf_model)
+{
+  ros::NodeHandle dynamics_nh(nh, "joint_space_dynamics");
+  dynamics_nh.param("enabled", jointSpaceDynamicsEnabled_, false);
+  if (!jointSpaceDynamicsEnabled_)
+  {
+    return true;
+  }
+
+  std::vector<double> gravity;
+  dynamics_nh.param("gravity", gravity, std::vector<double>{ 0., 0., -9.81 });
+  if (gravity.size() != 3)
+  {
+    ROS_ERROR_STREAM("Gravity of the joint-space dynamics must have 3 components");
+    return false;
+  }
+
+  if (!jointSpaceDynamics_.init(*urdf_model, jointBuffers_,
+                                eVector3(gravity[0], gravity[1], gravity[2])))
+  {
+    return false;
+  }
+
+  joint_space_dynamics_interface_.registerHandle(
+      JointSpaceDynamicsHandle("joint_space_dynamics", &jointSpaceDynamics_));
+  registerInterface(&joint_space_dynamics_interface_);
+  ROS_DEBUG_STREAM("Registered joint-space dynamics.");
+  return true;
+}
+
+PalHardwareGazebo::PalHardwareGazebo()
+  : DefaultRobotHWSim()
+  , jointSpaceDynamicsEnabled_(false)
+  , centerOfMassEnabled_(false)
+  , floatingBaseStateUsed_(false)
+  , batchedSlot_(0)
+  , introspectionFactor_(1)
+  , introspectionTicks_(0)
+{
+}
+
+bool PalHardwareGazebo::initSim(const std::string& robot_ns, ros::NodeHandle nh,
+                                gazebo::physics::ModelPtr model,
+                                const urdf::Model* const urdf_model,
+                                std::vector<transmission_interface::TransmissionInfo> transmissions)
+{
+  ROS_INFO_STREAM("Loading PAL HARWARE GAZEBO");
+
+  if (!DefaultRobotHWSim::initSim(robot_ns, nh, model, urdf_model, transmissions))
+  {
+    return false;
+  }
+
+  parseForceTorqueSensors(nh, model, urdf_model);
+  discoverForceTorqueSensors(nh, model);
+
+  for (size_t i = 0; i < forceTorqueSensorDefinitions_.size(); ++i)
+  {
+    ForceTorqueSensorDefinitionPtr& ft = forceTorqueSensorDefinitions_[i];
+    ft_sensor_interface_.registerHandle(ForceTorqueSensorHandle(
+        ft->sensorName, ft->sensorFrame, &ft->force[0], &ft->torque[0]));
+  }
+
+  registerInterface(&ft_sensor_interface_);
+  ROS_DEBUG_STREAM("Registered force-torque sensors.");
+
+  // Hardware interfaces: Base IMU sensors
+  parseIMUSensors(nh, model, urdf_model);
+
+  for (size_t i = 0; i < imuSensorDefinitions_.size(); ++i)
+  {
+    ImuSensorDefinitionPtr& imu = imuSensorDefinitions_[i];
+
+    ImuSensorHandle::Data data;
+    data.name = imu->sensorName;
+    data.frame_id = imu->sensorFrame;
+    data.orientation = &imu->orientation[0];
+    data.linear_acceleration = &imu->linear_acceleration[0];
+    data.angular_velocity = &imu->base_ang_vel[0];
+    imu_sensor_interface_.registerHandle(ImuSensorHandle(data));
+  }
+
+  registerInterface(&imu_sensor_interface_);
+  ROS_DEBUG_STREAM("Registered IMU sensor.");
+
+  if (!jointBuffers_.init(this, model))
+  {
+    return false;
+  }
+  controllerClaims_.init(jointBuffers_);
+  if (!parseJointGroups(nh) || !registerNameIndices())
+  {
+    return false;
+  }
+  collectSensorChannels();
+  registerIntrospection(nh);
+
+  floatingBaseState_.init(model);
+  if (!initControllerHost(nh, robot_ns) || !initCoSimulation(nh, robot_ns) ||
+      !initPolicy(nh) || !initBatchedStep(nh, model))
+  {
+    return false;
+  }
+
+  // The channels driven by the plugin are activated once, by a controller never stopped
+  if (!reservedClaims_.empty())
+  {
+    if (!DefaultRobotHWSim::prepareSwitch(reservedClaims_, std::list<ControllerInfo>()))
+    {
+      ROS_ERROR_STREAM("Could not activate the joints commanded by the plugin");
+      return false;
+    }
+    DefaultRobotHWSim::doSwitch(reservedClaims_, std::list<ControllerInfo>());
+  }
+
+  if (!hardwareEmulation_.init(nh, jointBuffers_, sensorChannels_))
+  {
+    return false;
+  }
+
+  if (!initSensorHealth(nh))
+  {
+    return false;
+  }
+
+  if (!writeSkipper_.init(nh, jointBuffers_))
+  {
+    return false;
+  }
+  if (writeSkipper_.enabled())
+  {
+    activeControlMethods_.assign(jointBuffers_.size(), JointBuffers::NO_COMMAND);
+    updateControlMethods(reservedClaims_, true);
+    writeSkipper_.setActiveResources(activeResourceNames(), activeControlMethods_);
+  }
+
+  if (!jointFriction_.init(nh, getIds(nh, "joint_friction"), model))
+  {
+    return false;
+  }
+
+  if (!mimicJoints_.init(nh, *urdf_model, model))
+  {
+    return false;
+  }
+
+  if (!initMobileBase(nh, model))
+  {
+    return false;
+  }
+
+  if (!graspManager_.init(nh, getIds(nh, "grasping"), jointBuffers_, model))
+  {
+    return false;
+  }
+
+  if (!initJointSpaceDynamics(nh, urdf_model))
+  {
+    return false;
+  }
+
+  nh.param("center_of_mass/enabled", centerOfMassEnabled_, false);
+  if (centerOfMassEnabled_)
+  {
+    if (!centerOfMassState_.init(model))
+    {
+      return false;
+    }
+    center_of_mass_interface_.registerHandle(
+        CenterOfMassHandle(centerOfMassState_.getHandleData("center_of_mass")));
+    registerInterface(&center_of_mass_interface_);
+    ROS_DEBUG_STREAM("Registered center of mass.");
+  }
+
+  if (!initColumnarExport(nh))
+  {
+    return false;
+  }
+
+  if (!initSensorRecording(nh))
+  {
+    return false;
+  }
+
+  if (!initLazyRead(nh))
+  {
+    return false;
+  }
+
+  if (!initLoadShedding(nh) || !initMetrics(nh, robot_ns))
+  {
+    return false;
+  }
+
+  initScheduling(nh, model);
+
+  return true;
+}
+
+PalHardwareGazebo::~PalHardwareGazebo()
+{
+  if (scheduler_)
+  {
+    scheduler_->remove(this);
+  }
+  if (batchedEnvironment_)
+  {
+    batchedEnvironment_->removeRobot(batchedSlot_);
+  }
+  for (size_t i = 0; i < registeredVariables_.size(); ++i)
+  {
+    UNREGISTER_VARIABLE(registeredVariables_[i]);
+  }
+}
+
+void PalHardwareGazebo::readSim(ros::Time time, ros::Duration period)
+{
+  if (batchedEnvironment_)
+  {
+    batchedEnvironment_->setControlPeriod(period);
+    batchReadPeriod_ = period;
+  }
+  if (scheduler_)
+  {
+    scheduler_->read(this, time, period);
+  }
+  else
+  {
+    readHardware(time, period);
+    readSerial(time, period);
+  }
+}
+
+void PalHardwareGazebo::writeSim(ros::Time time, ros::Duration period)
+{
+  if (scheduler_)
+  {
+    scheduler_->write(this, time, period);
+  }
+  else
+  {
+    writeHardware(time, period);
+    writeSerial(time, period);
+  }
+}
+
+void PalHardwareGazebo::readSerial(const ros::Time& time, const ros::Duration& period)
+{
+  // Creates and removes joints in the world
+  if (graspManager_.enabled())
+  {
+    graspManager_.update();
+  }
+}
+
+void PalHardwareGazebo::writeSerial(const ros::Time& time, const ros::Duration& period)
+{
+  // Goes through the process wide introspection registry
+  if (++introspectionTicks_ >= introspectionFactor_)
+  {
+    introspectionTicks_ = 0;
+    PUBLISH_ASYNC_STATISTICS("/introspection_data")
+  }
+}
+
+void PalHardwareGazebo::readHardware(const ros::Time& time, const ros::Duration& period)
+{
+  if (loadShedder_.enabled())
+  {
+    loadShedder_.startPhase();
+  }
+  if (metrics_.enabled())
+  {
+    metrics_.startPhase();
+  }
+  readResources(time, period);
+  if (kinematicBase_.enabled())
+  {
+    kinematicBase_.read(period);
+  }
+  if (wheelOdometry_.enabled())
+  {
+    wheelOdometry_.update(time, period);
+  }
+
+  readSensors();
+
+  if (hardwareEmulation_.enabled())
+  {
+    hardwareEmulation_.processSensors();
+  }
+  if (sensorHealth_.enabled())
+  {
+    sensorHealth_.update(time);
+    if (metrics_.enabled())
+    {
+      for (size_t i = 0; i < sensorHealth_.sensorCount(); ++i)
+      {
+        metrics_.setSensorHealth(i, sensorHealth_.sensorFlags(i), sensorHealth_.unchangedTicks(i));
+      }
+    }
+  }
+
+  if (sensorStreamRecorder_.enabled())
+  {
+    sensorStreamRecorder_.record(time);
+  }
+
+  for (size_t i = 0; i < jointGroups_.size(); ++i)
+  {
+    jointGroups_[i]->gatherState();
+  }
+
+  if (jointSpaceDynamicsEnabled_)
+  {
+    jointSpaceDynamics_.newTick();
+  }
+
+  if (centerOfMassEnabled_)
+  {
+    centerOfMassState_.update();
+  }
+
+  if (controllerHost_.enabled())
+  {
+    controllerHost_.publishState(time, period);
+  }
+  if (coSimulation_.enabled())
+  {
+    coSimulation_.notify(time, period);
+  }
+  if (floatingBaseStateUsed_)
+  {
+    floatingBaseState_.update();
+  }
+  if (policyHook_.enabled())
+  {
+    policyHook_.step(time);
+  }
+  if (batchedEnvironment_)
+  {
+    batchObservationLayout_.gather(batchedEnvironment_->robotObservation(batchedSlot_));
+  }
+
+  if (loadShedder_.enabled())
+  {
+    loadShedder_.stopPhase();
+  }
+  if (metrics_.enabled())
+  {
+    metrics_.stopPhase(MetricsExporter::READ_PHASE);
+  }
+}
+
+void PalHardwareGazebo::refreshBatchObservation(const ros::Time& time)
+{
+  // Only the observed state is refreshed, the next tick reads as usual
+  for (size_t i = 0; i < rw_resources_.size(); ++i)
+  {
+    if (!kinematicBase_.enabled() || !kinematicBase_.ownsResource(i))
+    {
+      rw_resources_[i]->read(time, batchReadPeriod_, e_stop_active_);
+    }
+  }
+  readSensors();
+  if (floatingBaseStateUsed_)
+  {
+    floatingBaseState_.update();
+  }
+  batchObservationLayout_.gather(batchedEnvironment_->robotObservation(batchedSlot_));
+}
+
+void PalHardwareGazebo::readSensors()
+{
+  // Read force-torque sensors
+  for (size_t i = 0; i < forceTorqueSensorDefinitions_.size(); ++i)
+  {
+    ForceTorqueSensorDefinitionPtr& ft = forceTorqueSensorDefinitions_[i];
+    if (ft->gazebo_ft_sensor)
+    {
+      // Already computed by the SDF sensor, brought back to the joint wrench convention
+      const ignition::math::Vector3d force = ft->gazebo_ft_sensor->Force();
+      const ignition::math::Vector3d torque = ft->gazebo_ft_sensor->Torque();
+      Eigen::Map<eVector3>(ft->force) =
+          ft->sdfToChild * eVector3(force.X(), force.Y(), force.Z());
+      Eigen::Map<eVector3>(ft->torque) =
+          ft->sdfToChild * eVector3(torque.X(), torque.Y(), torque.Z());
+    }
+    else
+    {
+      gazebo::physics::JointWrench ft_wrench = ft->gazebo_joint->GetForceTorque(0u);
+
+      #if GAZEBO_MAJOR_VERSION < 8
+        ft->force[0] = ft_wrench.body2Force.x;
+        ft->force[1] = ft_wrench.body2Force.y;
+        ft->force[2] = ft_wrench.body2Force.z;
+        ft->torque[0] = ft_wrench.body2Torque.x;
+        ft->torque[1] = ft_wrench.body2Torque.y;
+        ft->torque[2] = ft_wrench.body2Torque.z;
+      #else
+        ft->force[0] = ft_wrench.body2Force.X();
+        ft->force[1] = ft_wrench.body2Force.Y();
+        ft->force[2] = ft_wrench.body2Force.Z();
+        ft->torque[0] = ft_wrench.body2Torque.X();
+        ft->torque[1] = ft_wrench.body2Torque.Y();
+        ft->torque[2] = ft_wrench.body2Torque.Z();
+      #endif
+    }
+
+    // Transform to sensor frame
+    Eigen::MatrixXd transform(6, 6);
+    transform.setZero();
+    transform.block(0, 0, 3, 3) = Eigen::Matrix3d::Identity();
+    transform.block(3, 3, 3, 3) = ft->sensorTransform.rotation().transpose();
+    eVector3 r = ft->sensorTransform.translation();
+    transform.block(3, 0, 3, 3) = skew(r) * ft->sensorTransform.rotation().transpose();
+
+    Eigen::VectorXd wrench(6);
+    wrench << ft->torque[0], ft->torque[1], ft->torque[2], ft->force[0], ft->force[1],
+        ft->force[2];
+    Eigen::VectorXd transformedWrench(6);
+
+    transformedWrench = transform * wrench;
+
+    ft->torque[0] = transformedWrench(0);
+    ft->torque[1] = transformedWrench(1);
+    ft->torque[2] = transformedWrench(2);
+    ft->force[0] = transformedWrench(3);
+    ft->force[1] = transformedWrench(4);
+    ft->force[2] = transformedWrench(5);
+  }
+
+  // Read IMU sensor
+  for (size_t i = 0; i < imuSensorDefinitions_.size(); ++i)
+  {
+    ImuSensorDefinitionPtr& imu = imuSensorDefinitions_[i];
+
+    gazebo::math::Quaternion imu_quat = imu->gazebo_imu_sensor->Orientation();
+    imu->orientation[0] = imu_quat.x;
+    imu->orientation[1] = imu_quat.y;
+    imu->orientation[2] = imu_quat.z;
+    imu->orientation[3] = imu_quat.w;
+
+    gazebo::math::Vector3 imu_ang_vel = imu->gazebo_imu_sensor->AngularVelocity();
+    imu->base_ang_vel[0] = imu_ang_vel.x;
+    imu->base_ang_vel[1] = imu_ang_vel.y;
+    imu->base_ang_vel[2] = imu_ang_vel.z;
+
+    gazebo::math::Vector3 imu_lin_acc = imu->gazebo_imu_sensor->LinearAcceleration();
+    imu->linear_acceleration[0] = imu_lin_acc.x;
+    imu->linear_acceleration[1] = imu_lin_acc.y;
+    imu->linear_acceleration[2] = imu_lin_acc.z;
+  }
+}
+
+void PalHardwareGazebo::readResources(const ros::Time& time, const ros::Duration& period)
+{
+  if (!lazyJointReader_.enabled() && !kinematicBase_.enabled())
+  {
+    // read all resources
+    BOOST_FOREACH (RwResPtr res, rw_resources_)
+    {
+      res->read(time, period, e_stop_active_);
+    }
+    return;
+  }
+
+  // read the referenced resources, refresh the others in the background
+  if (lazyJointReader_.enabled())
+  {
+    lazyJointReader_.newTick();
+  }
+  for (size_t i = 0; i < rw_resources_.size(); ++i)
+  {
+    if (kinematicBase_.enabled() && kinematicBase_.ownsResource(i))
+    {
+      continue;
+    }
+    if (lazyJointReader_.enabled() && !lazyJointReader_.shouldRead(i))
+    {
+      continue;
+    }
+    rw_resources_[i]->read(time, period, e_stop_active_);
+  }
+}
+
+void PalHardwareGazebo::writeResources(const ros::Time& time, const ros::Duration& period)
+{
+  const RwResources& resources = writtenResources();
+  if (!writeSkipper_.enabled() && !kinematicBase_.enabled())
+  {
+    BOOST_FOREACH (RwResPtr res, resources)
+    {
+      res->write(time, period, e_stop_active_);
+    }
+    return;
+  }
+
+  for (size_t i = 0; i < resources.size(); ++i)
+  {
+    if (kinematicBase_.ownsActiveResource(i))
+    {
+      continue;
+    }
+    if (writeSkipper_.enabled() && writeSkipper_.skip(i, e_stop_active_))
+    {
+      continue;
+    }
+    resources[i]->write(time, period, e_stop_active_);
+    if (writeSkipper_.enabled())
+    {
+      writeSkipper_.written(i, e_stop_active_);
+    }
+  }
+}
+
+void PalHardwareGazebo::writeHardware(const ros::Time& time, const ros::Duration& period)
+{
+  if (controllerHost_.enabled())
+  {
+    // Holds the previous commands if the controller process is late
+    controllerHost_.receiveCommands();
+  }
+  if (coSimulation_.enabled())
+  {
+    coSimulation_.acknowledge();
+  }
+  if (policyHook_.enabled())
+  {
+    policyHook_.apply();
+  }
+  if (batchedEnvironment_)
+  {
+    batchActionLayout_.scatter(batchedEnvironment_->robotAction(batchedSlot_));
+  }
+
+  // The waits above depend on other processes, they are not part of the tick cost
+  if (loadShedder_.enabled())
+  {
+    loadShedder_.startPhase();
+  }
+  if (metrics_.enabled())
+  {
+    metrics_.startPhase();
+  }
+
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  const ResourceBitset& active_groups = controllerClaims_.activeGroups();
+  for (size_t i = 0; i < jointGroups_.size(); ++i)
+  {
+    if (active_groups.test(i))
+    {
+      jointGroups_[i]->scatterCommands();
+    }
+  }
+  if (hardwareEmulation_.enabled())
+  {
+    hardwareEmulation_.delayCommands();
+  }
+  writeResources(time, period);
+  if (kinematicBase_.enabled())
+  {
+    kinematicBase_.write();
+  }
+  if (jointFriction_.enabled())
+  {
+    jointFriction_.apply();
+  }
+  if (mimicJoints_.enabled())
+  {
+    mimicJoints_.apply();
+  }
+  if (hardwareEmulation_.enabled())
+  {
+    hardwareEmulation_.restoreCommands();
+  }
+  if (columnarExporter_.enabled())
+  {
+    columnarExporter_.record(time);
+  }
+
+  if (loadShedder_.enabled())
+  {
+    loadShedder_.stopPhase();
+    loadShedder_.endTick(period);
+  }
+  if (metrics_.enabled())
+  {
+    metrics_.stopPhase(MetricsExporter::WRITE_PHASE);
+    metrics_.endTick(period);
+  }
+}
+
+bool PalHardwareGazebo::checkForConflict(const std::list<ControllerInfo>& info) const
+{
+  std::string resource;
+  if (controllerClaims_.findConflict(info, resource))
+  {
+    ROS_WARN_STREAM("Resource conflict on [" << resource << "]");
+    return true;
+  }
+  return false;
+}
+
+std::list<ControllerInfo>
+PalHardwareGazebo::expandGroupClaims(const std::list<ControllerInfo>& controllers) const
+{
+  std::list<ControllerInfo> expanded = controllers;
+  for (std::list<ControllerInfo>::iterator it = expanded.begin(); it != expanded.end(); ++it)
+  {
+    std::vector<InterfaceResources> claims;
+    for (size_t i = 0; i < it->claimed_resources.size(); ++i)
+    {
+      const InterfaceResources& claim = it->claimed_resources[i];
+      std::set<string> kept;
+      for (std::set<string>::const_iterator res = claim.resources.begin();
+           res != claim.resources.end(); ++res)
+      {
+        // Joint names win over group names, as in the claim bitsets
+        const int group =
+            jointBuffers_.index(*res) < 0 ? controllerClaims_.groupIndex().find(*res) : -1;
+        if (group < 0)
+        {
+          kept.insert(*res);
+        }
+        else
+        {
+          addClaims(claims, jointGroups_[group]->getInterfaceName(),
+                    jointGroups_[group]->getJointNames());
+        }
+      }
+      if (!kept.empty())
+      {
+        addClaims(claims, claim.hardware_interface, kept);
+      }
+    }
+    it->claimed_resources = claims;
+  }
+  return expanded;
+}
+
+void PalHardwareGazebo::updateControlMethods(const std::list<ControllerInfo>& controllers,
+                                             bool started)
+{
+  for (std::list<ControllerInfo>::const_iterator it = controllers.begin();
+       it != controllers.end(); ++it)
+  {
+    for (size_t i = 0; i < it->claimed_resources.size(); ++i)
+    {
+      const InterfaceResources& claim = it->claimed_resources[i];
+      const JointBuffers::CommandType method =
+          started ? JointBuffers::fromInterfaceName(claim.hardware_interface) :
+                    JointBuffers::NO_COMMAND;
+      for (std::set<string>::const_iterator res = claim.resources.begin();
+           res != claim.resources.end(); ++res)
+      {
+        const int joint = jointBuffers_.index(*res);
+        if (joint >= 0)
+        {
+          activeControlMethods_[joint] = method;
+        }
+      }
+    }
+  }
+}
+
+bool PalHardwareGazebo::prepareSwitch(const std::list<ControllerInfo>& start_list,
+                                      const std::list<ControllerInfo>& stop_list)
+{
+  std::string resource;
+  if (controllerClaims_.findSwitchConflict(start_list, stop_list, resource))
+  {
+    ROS_ERROR_STREAM("Cannot switch controllers, resource [" << resource
+                                                             << "] would be claimed twice");
+    return false;
+  }
+  if (!DefaultRobotHWSim::prepareSwitch(expandGroupClaims(start_list),
+                                        expandGroupClaims(stop_list)))
+  {
+    return false;
+  }
+  if (metrics_.enabled())
+  {
+    metrics_.switchRequested();
+  }
+  return true;
+}
+
+void PalHardwareGazebo::doSwitch(const std::list<ControllerInfo>& start_list,
+                                 const std::list<ControllerInfo>& stop_list)
+{
+  const ResourceBitset previous_groups = controllerClaims_.activeGroups();
+  controllerClaims_.doSwitch(start_list, stop_list);
+
+  // Newly claimed groups start from the commands currently held by the joints
+  const ResourceBitset& active_groups = controllerClaims_.activeGroups();
+  for (size_t i = 0; i < jointGroups_.size(); ++i)
+  {
+    if (active_groups.test(i) && !previous_groups.test(i))
+    {
+      jointGroups_[i]->gatherCommands();
+    }
+  }
+  // The base class only knows about joints, it activates the joints of the claimed groups
+  const std::list<ControllerInfo> expanded_start = expandGroupClaims(start_list);
+  const std::list<ControllerInfo> expanded_stop = expandGroupClaims(stop_list);
+  DefaultRobotHWSim::doSwitch(expanded_start, expanded_stop);
+
+  if (writeSkipper_.enabled() || kinematicBase_.enabled())
+  {
+    const std::vector<std::string> names = activeResourceNames();
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    if (writeSkipper_.enabled())
+    {
+      updateControlMethods(expanded_stop, false);
+      updateControlMethods(expanded_start, true);
+      writeSkipper_.setActiveResources(names, activeControlMethods_);
+    }
+    if (kinematicBase_.enabled())
+    {
+      kinematicBase_.setActiveResources(names);
+    }
+  }
+
+  if (lazyJointReader_.enabled())
+  {
+    lazyJointReader_.update(controllerClaims_.active());
+  }
+  if (metrics_.enabled())
   {
-    res->write(time, period, e_stop_active_);
+    metrics_.switchDone();
   }
-  PUBLISH_ASYNC_STATISTICS("/introspection_data")
 }
 }
 
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <dlfcn.h>
+
+#include <pal_hardware_gazebo/policy_hook.h>
+
+namespace gazebo_ros_control
+{
+PolicyHook::PolicyHook()
+  : library_(NULL)
+  , policy_(NULL)
+  , step_(NULL)
+  , destroy_(NULL)
+  , actionValid_(false)
+{
+}
+
+PolicyHook::~PolicyHook()
+{
+  if (policy_)
+  {
+    destroy_(policy_);
+  }
+  if (library_)
+  {
+    dlclose(library_);
+  }
+}
+
+bool PolicyHook::init(ros::NodeHandle& nh, const std::vector<std::string>& channel_names,
+                      const std::vector<double*>& channels,
+                      const std::vector<std::string>& command_names,
+                      const std::vector<double*>& commands)
+{
+  ros::NodeHandle policy_nh(nh, "policy");
+  std::string library, config;
+  if (!policy_nh.getParam("library", library))
+  {
+    return true;
+  }
+  policy_nh.param<std::string>("config", config, "");
+  std::vector<std::string> observations, actions;
+  policy_nh.getParam("observations", observations);
+  policy_nh.getParam("actions", actions);
+
+  if (!observationLayout_.init(observations, channel_names, channels) ||
+      !actionLayout_.init(actions, command_names, commands))
+  {
+    return false;
+  }
+  observation_.resize(observationLayout_.size());
+  action_.resize(actionLayout_.size());
+  actionLayout_.gather(action_.data());
+
+  library_ = dlopen(library.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (!library_)
+  {
+    ROS_ERROR_STREAM("Could not load policy library: " << dlerror());
+    return false;
+  }
+  pal_policy_create_fn create =
+      reinterpret_cast<pal_policy_create_fn>(dlsym(library_, PAL_POLICY_CREATE_SYMBOL));
+  step_ = reinterpret_cast<pal_policy_step_fn>(dlsym(library_, PAL_POLICY_STEP_SYMBOL));
+  destroy_ = reinterpret_cast<pal_policy_destroy_fn>(dlsym(library_, PAL_POLICY_DESTROY_SYMBOL));
+  if (!create || !step_ || !destroy_)
+  {
+    ROS_ERROR_STREAM("Policy library " << library << " does not export the policy interface");
+    return false;
+  }
+  policy_ = create(config.c_str(), observation_.size(), action_.size());
+  if (!policy_)
+  {
+    ROS_ERROR_STREAM("Policy library " << library << " could not create its policy");
+    return false;
+  }
+
+  ROS_INFO_STREAM("Loaded policy " << library << " with " << observation_.size()
+                                   << " observations and " << action_.size() << " actions");
+  return true;
+}
+
+void PolicyHook::step(const ros::Time& time)
+{
+  observationLayout_.gather(observation_.data());
+  actionValid_ = step_(policy_, time.toSec(), observation_.data(), action_.data()) == 0;
+  if (!actionValid_)
+  {
+    ROS_WARN_STREAM_THROTTLE(1.0, "Policy step failed, holding the previous commands");
+  }
+}
+
+void PolicyHook::apply()
+{
+  if (actionValid_)
+  {
+    actionLayout_.scatter(action_.data());
+  }
+}
+}
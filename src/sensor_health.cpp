@@ -0,0 +1,216 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <algorithm>
+#include <limits>
+
+#include <pal_hardware_gazebo/sensor_health.h>
+
+namespace gazebo_ros_control
+{
+namespace
+{
+bool startsWith(const std::string& name, const std::string& prefix)
+{
+  return name.compare(0, prefix.size(), prefix) == 0;
+}
+
+/// Index of the longest prefix of name, -1 if none
+int longestPrefix(const std::string& name, const std::vector<std::string>& prefixes)
+{
+  int best = -1;
+  for (size_t i = 0; i < prefixes.size(); ++i)
+  {
+    if (startsWith(name, prefixes[i]) &&
+        (best < 0 || prefixes[i].size() > prefixes[best].size()))
+    {
+      best = i;
+    }
+  }
+  return best;
+}
+}
+
+SensorHealth::SensorHealth()
+  : enabled_(false), staleTicks_(0), reportedNonFinite_(false), publishDivider_(0), ticks_(0)
+{
+}
+
+bool SensorHealth::init(ros::NodeHandle& nh, const std::vector<std::string>& names,
+                        const std::vector<double*>& channels,
+                        const std::vector<std::string>& default_stale_prefixes)
+{
+  ros::NodeHandle health_nh(nh, "sensor_health");
+  health_nh.param("enabled", enabled_, false);
+  if (!enabled_)
+  {
+    return true;
+  }
+
+  std::vector<std::string> saturation_prefixes, stale_prefixes;
+  std::vector<double> saturation_limits;
+  health_nh.getParam("saturation_prefixes", saturation_prefixes);
+  health_nh.getParam("saturation_limits", saturation_limits);
+  health_nh.param("stale_ticks", staleTicks_, 0);
+  if (!health_nh.getParam("stale_channels", stale_prefixes))
+  {
+    stale_prefixes = default_stale_prefixes;
+  }
+  health_nh.param("publish_divider", publishDivider_, 100);
+  if (saturation_prefixes.size() != saturation_limits.size() || staleTicks_ < 0 ||
+      publishDivider_ < 0)
+  {
+    ROS_ERROR_STREAM("Invalid sensor health parameters");
+    return false;
+  }
+
+  const size_t n = channels.size();
+  channels_ = channels;
+  values_.setZero(n);
+  previous_.setZero(n);
+  limits_.setConstant(n, std::numeric_limits<double>::infinity());
+  unchangedTicks_.setZero(n);
+  flags_.setZero(n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    const int limit = longestPrefix(names[i], saturation_prefixes);
+    if (limit >= 0)
+    {
+      limits_(i) = saturation_limits[limit];
+    }
+
+    // Channels of a sensor are contiguous
+    const std::string sensor = names[i].substr(0, names[i].rfind('/'));
+    if (sensors_.empty() || sensors_.back().name != sensor)
+    {
+      Sensor s;
+      s.name = sensor;
+      s.first = i;
+      s.count = 0;
+      s.staleCheck = false;
+      sensors_.push_back(s);
+    }
+    ++sensors_.back().count;
+    sensors_.back().staleCheck = sensors_.back().staleCheck ||
+                                 (staleTicks_ > 0 && longestPrefix(names[i], stale_prefixes) >= 0);
+  }
+  sensorFlags_.assign(sensors_.size(), SensorHealthHandle::HEALTHY);
+  sensorUnchangedTicks_.assign(sensors_.size(), 0);
+
+  if (publishDivider_ > 0)
+  {
+    publisher_.reset(new realtime_tools::RealtimePublisher<diagnostic_msgs::DiagnosticArray>(
+        nh, "/diagnostics", 1));
+    diagnostic_msgs::DiagnosticArray& msg = publisher_->msg_;
+    msg.status.resize(sensors_.size());
+    for (size_t i = 0; i < sensors_.size(); ++i)
+    {
+      msg.status[i].name = "Sensor health: " + sensors_[i].name;
+      msg.status[i].hardware_id = sensors_[i].name;
+      msg.status[i].message.reserve(64);
+    }
+  }
+
+  ROS_INFO_STREAM("Checking the health of " << n << " channels of " << sensors_.size()
+                                            << " sensors");
+  return true;
+}
+
+void SensorHealth::update(const ros::Time& time)
+{
+  for (size_t i = 0; i < channels_.size(); ++i)
+  {
+    values_(i) = *channels_[i];
+  }
+
+  // Single expressions into preallocated arrays, nothing is allocated
+  unchangedTicks_ = (values_ == previous_).select(unchangedTicks_ + 1, 0);
+  flags_ = (!values_.isFinite()).cast<int>() * static_cast<int>(SensorHealthHandle::NON_FINITE) +
+           (values_.isFinite() && values_.abs() >= limits_).cast<int>() *
+               static_cast<int>(SensorHealthHandle::SATURATED);
+  previous_ = values_;
+
+  bool any_non_finite = false;
+  for (size_t i = 0; i < sensors_.size(); ++i)
+  {
+    unsigned int flags = 0;
+    int unchanged = unchangedTicks_(sensors_[i].first);
+    for (size_t j = sensors_[i].first; j < sensors_[i].first + sensors_[i].count; ++j)
+    {
+      flags |= flags_(j);
+      unchanged = std::min(unchanged, unchangedTicks_(j));
+    }
+    // Stale only if no value of the sensor changed, not as soon as one of them holds still
+    if (sensors_[i].staleCheck && unchanged >= staleTicks_)
+    {
+      flags |= SensorHealthHandle::STALE;
+    }
+    sensorFlags_[i] = flags;
+    sensorUnchangedTicks_[i] = unchanged;
+    any_non_finite = any_non_finite || (flags & SensorHealthHandle::NON_FINITE);
+  }
+
+  // The first non finite value usually means the simulation is exploding
+  if (any_non_finite && !reportedNonFinite_)
+  {
+    ROS_ERROR_STREAM("Non finite sensor values at time " << time.toSec());
+  }
+  reportedNonFinite_ = any_non_finite;
+
+  if (publisher_ && ++ticks_ >= publishDivider_)
+  {
+    ticks_ = 0;
+    publish(time);
+  }
+}
+
+void SensorHealth::publish(const ros::Time& time)
+{
+  if (!publisher_->trylock())
+  {
+    return;
+  }
+  diagnostic_msgs::DiagnosticArray& msg = publisher_->msg_;
+  msg.header.stamp = time;
+  for (size_t i = 0; i < sensors_.size(); ++i)
+  {
+    diagnostic_msgs::DiagnosticStatus& status = msg.status[i];
+    const unsigned int flags = sensorFlags_[i];
+    if (flags & SensorHealthHandle::NON_FINITE)
+    {
+      status.level = diagnostic_msgs::DiagnosticStatus::ERROR;
+      status.message = "Non finite value";
+    }
+    else if (flags & SensorHealthHandle::SATURATED)
+    {
+      status.level = diagnostic_msgs::DiagnosticStatus::WARN;
+      status.message = "Saturated";
+    }
+    else if (flags & SensorHealthHandle::STALE)
+    {
+      status.level = diagnostic_msgs::DiagnosticStatus::WARN;
+      status.message = "Stale";
+    }
+    else
+    {
+      status.level = diagnostic_msgs::DiagnosticStatus::OK;
+      status.message = "OK";
+    }
+  }
+  publisher_->unlockAndPublish();
+}
+
+void SensorHealth::registerHandles(SensorHealthInterface& iface) const
+{
+  for (size_t i = 0; i < sensors_.size(); ++i)
+  {
+    iface.registerHandle(SensorHealthHandle(sensors_[i].name, &sensorFlags_[i]));
+  }
+}
+}
@@ -0,0 +1,438 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <pal_hardware_gazebo/sensor_stream_recorder.h>
+
+namespace gazebo_ros_control
+{
+namespace
+{
+unsigned int leadingZeros(uint64_t x)
+{
+  return x == 0 ? 64 : __builtin_clzll(x);
+}
+
+unsigned int trailingZeros(uint64_t x)
+{
+  return x == 0 ? 64 : __builtin_ctzll(x);
+}
+
+uint64_t zigzag(int64_t x)
+{
+  return (static_cast<uint64_t>(x) << 1) ^ static_cast<uint64_t>(x >> 63);
+}
+
+int64_t unzigzag(uint64_t x)
+{
+  return static_cast<int64_t>(x >> 1) ^ -static_cast<int64_t>(x & 1);
+}
+
+const char MAGIC[8] = { 'P', 'A', 'L', 'R', 'E', 'C', '0', '1' };
+}
+
+BitWriter::BitWriter() : accumulator_(0), pending_(0)
+{
+}
+
+void BitWriter::clear()
+{
+  bytes_.clear();
+  accumulator_ = 0;
+  pending_ = 0;
+}
+
+void BitWriter::write(uint64_t value, unsigned int bits)
+{
+  while (bits > 0)
+  {
+    const unsigned int chunk = std::min(bits, 8u - pending_);
+    const uint64_t part = (value >> (bits - chunk)) & ((1ull << chunk) - 1);
+    accumulator_ = (accumulator_ << chunk) | part;
+    pending_ += chunk;
+    bits -= chunk;
+    if (pending_ == 8)
+    {
+      bytes_.push_back(static_cast<uint8_t>(accumulator_));
+      accumulator_ = 0;
+      pending_ = 0;
+    }
+  }
+}
+
+void BitWriter::flush()
+{
+  if (pending_ > 0)
+  {
+    write(0, 8 - pending_);
+  }
+}
+
+BitReader::BitReader(const uint8_t* data, size_t size) : data_(data), size_(size), position_(0)
+{
+}
+
+bool BitReader::read(unsigned int bits, uint64_t& value)
+{
+  if (position_ + bits > size_ * 8)
+  {
+    return false;
+  }
+  uint64_t result = 0;
+  while (bits > 0)
+  {
+    const unsigned int offset = position_ % 8;
+    const unsigned int chunk = std::min(bits, 8u - offset);
+    const unsigned int byte = data_[position_ / 8];
+    result = (result << chunk) | ((byte >> (8 - offset - chunk)) & ((1u << chunk) - 1));
+    position_ += chunk;
+    bits -= chunk;
+  }
+  value = result;
+  return true;
+}
+
+SensorStreamRecorder::SensorStreamRecorder()
+  : enabled_(false)
+  , blockRows_(1000)
+  , bufferRows_(10000)
+  , decimation_(1)
+  , blockFill_(0)
+  , previousTime_(0)
+  , previousDelta_(0)
+  , rawBytes_(0)
+  , writtenBytes_(0)
+{
+}
+
+SensorStreamRecorder::~SensorStreamRecorder()
+{
+  stop();
+}
+
+bool SensorStreamRecorder::configure(ros::NodeHandle& nh)
+{
+  ros::NodeHandle recording_nh(nh, "sensor_recording");
+  recording_nh.param("file", fileName_, std::string());
+  enabled_ = !fileName_.empty();
+  if (!enabled_)
+  {
+    return true;
+  }
+
+  int block_rows, buffer_rows, decimation;
+  recording_nh.param("block_rows", block_rows, 1000);
+  recording_nh.param("buffer_rows", buffer_rows, 10000);
+  recording_nh.param("decimation", decimation, 1);
+  if (block_rows <= 0 || buffer_rows <= 0 || decimation <= 0)
+  {
+    ROS_ERROR_STREAM("Sensor recording sizes and decimation must be positive");
+    enabled_ = false;
+    return false;
+  }
+  return configure(fileName_, block_rows, buffer_rows, decimation);
+}
+
+bool SensorStreamRecorder::configure(const std::string& file_name, size_t block_rows,
+                                     size_t buffer_rows, unsigned int decimation)
+{
+  fileName_ = file_name;
+  enabled_ = !fileName_.empty() && block_rows > 0 && buffer_rows > 0 && decimation > 0;
+  blockRows_ = block_rows;
+  bufferRows_ = buffer_rows;
+  decimation_ = decimation;
+  return true;
+}
+
+bool SensorStreamRecorder::start()
+{
+  states_.resize(names_.size() - 1);
+  resetBlock();
+  enabled_ = BufferedSignalWriter::start(fileName_, bufferRows_, decimation_);
+  return enabled_;
+}
+
+bool SensorStreamRecorder::writeHeader()
+{
+  file_.write(MAGIC, sizeof(MAGIC));
+  const uint32_t signals = names_.size();
+  file_.write(reinterpret_cast<const char*>(&signals), sizeof(signals));
+  for (size_t i = 0; i < names_.size(); ++i)
+  {
+    const uint16_t length = names_[i].size();
+    file_.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    file_.write(names_[i].data(), length);
+  }
+  return file_.good();
+}
+
+void SensorStreamRecorder::resetBlock()
+{
+  bits_.clear();
+  blockFill_ = 0;
+  previousTime_ = 0;
+  previousDelta_ = 0;
+  for (size_t i = 0; i < states_.size(); ++i)
+  {
+    states_[i].previous = 0;
+    // No reusable window at the start of a block
+    states_[i].leading = 64;
+    states_[i].trailing = 64;
+  }
+}
+
+void SensorStreamRecorder::encodeTime(int64_t time)
+{
+  const int64_t delta = time - previousTime_;
+  const uint64_t dod = zigzag(delta - previousDelta_);
+  previousTime_ = time;
+  previousDelta_ = delta;
+
+  if (dod == 0)
+  {
+    bits_.write(0x0, 1);
+  }
+  else if (dod < (1ull << 7))
+  {
+    bits_.write(0x2, 2);
+    bits_.write(dod, 7);
+  }
+  else if (dod < (1ull << 9))
+  {
+    bits_.write(0x6, 3);
+    bits_.write(dod, 9);
+  }
+  else if (dod < (1ull << 12))
+  {
+    bits_.write(0xE, 4);
+    bits_.write(dod, 12);
+  }
+  else
+  {
+    bits_.write(0xF, 4);
+    bits_.write(dod, 64);
+  }
+}
+
+void SensorStreamRecorder::encodeValue(double value, XorState& state)
+{
+  uint64_t value_bits;
+  std::memcpy(&value_bits, &value, sizeof(value_bits));
+  const uint64_t x = value_bits ^ state.previous;
+  state.previous = value_bits;
+
+  if (x == 0)
+  {
+    bits_.write(0x0, 1);
+    return;
+  }
+
+  const unsigned int leading = std::min(leadingZeros(x), 31u);
+  const unsigned int trailing = trailingZeros(x);
+  if (state.leading + state.trailing < 64 && leading >= state.leading &&
+      trailing >= state.trailing)
+  {
+    // Meaningful bits fit in the previous window
+    bits_.write(0x2, 2);
+    bits_.write(x >> state.trailing, 64 - state.leading - state.trailing);
+    return;
+  }
+
+  const unsigned int meaningful = 64 - leading - trailing;
+  bits_.write(0x3, 2);
+  bits_.write(leading, 5);
+  bits_.write(meaningful - 1, 6);
+  bits_.write(x >> trailing, meaningful);
+  state.leading = leading;
+  state.trailing = trailing;
+}
+
+void SensorStreamRecorder::writeRow(const double* row)
+{
+  encodeTime(static_cast<int64_t>(std::floor(row[0] * 1e9 + 0.5)));
+  for (size_t i = 0; i < states_.size(); ++i)
+  {
+    encodeValue(row[i + 1], states_[i]);
+  }
+  rawBytes_ += names_.size() * sizeof(double);
+
+  if (++blockFill_ == blockRows_)
+  {
+    flushBlock();
+  }
+}
+
+void SensorStreamRecorder::flushBlock()
+{
+  if (blockFill_ == 0)
+  {
+    return;
+  }
+  bits_.flush();
+  const uint32_t rows = blockFill_;
+  const uint32_t size = bits_.bytes().size();
+  file_.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+  file_.write(reinterpret_cast<const char*>(&size), sizeof(size));
+  file_.write(reinterpret_cast<const char*>(&bits_.bytes()[0]), size);
+  file_.flush();
+  writtenBytes_ += sizeof(rows) + sizeof(size) + size;
+  resetBlock();
+}
+
+void SensorStreamRecorder::finish()
+{
+  flushBlock();
+  if (writtenBytes_ > 0)
+  {
+    ROS_INFO_STREAM("Sensor recording compression ratio: "
+                    << static_cast<double>(rawBytes_) / writtenBytes_);
+  }
+}
+
+bool SensorStreamReader::open(const std::string& file_name)
+{
+  file_.open(file_name.c_str(), std::ios::binary);
+  if (!file_ || !readSignalNames(file_, MAGIC, names_) || names_.empty())
+  {
+    return false;
+  }
+  states_.resize(names_.size() - 1);
+  return true;
+}
+
+bool SensorStreamReader::readBlock(std::vector<double>& rows)
+{
+  uint32_t count = 0, size = 0;
+  file_.read(reinterpret_cast<char*>(&count), sizeof(count));
+  file_.read(reinterpret_cast<char*>(&size), sizeof(size));
+  if (!file_ || count == 0)
+  {
+    return false;
+  }
+  block_.resize(size);
+  if (size > 0)
+  {
+    file_.read(reinterpret_cast<char*>(&block_[0]), size);
+  }
+  if (!file_)
+  {
+    return false;
+  }
+
+  // Mirrors SensorStreamRecorder::resetBlock()
+  previousTime_ = 0;
+  previousDelta_ = 0;
+  for (size_t i = 0; i < states_.size(); ++i)
+  {
+    states_[i].previous = 0;
+    states_[i].leading = 64;
+    states_[i].trailing = 64;
+  }
+
+  BitReader bits(size > 0 ? &block_[0] : NULL, size);
+  decoded_.resize(static_cast<size_t>(count) * names_.size());
+  double* row = decoded_.empty() ? NULL : &decoded_[0];
+  for (uint32_t r = 0; r < count; ++r)
+  {
+    int64_t time;
+    if (!decodeTime(bits, time))
+    {
+      return false;
+    }
+    row[0] = time * 1e-9;
+    for (size_t i = 0; i < states_.size(); ++i)
+    {
+      if (!decodeValue(bits, states_[i], row[i + 1]))
+      {
+        return false;
+      }
+    }
+    row += names_.size();
+  }
+  rows.insert(rows.end(), decoded_.begin(), decoded_.end());
+  return true;
+}
+
+bool SensorStreamReader::decodeTime(BitReader& bits, int64_t& time)
+{
+  // Prefixes 0, 10, 110, 1110 and 1111, see SensorStreamRecorder::encodeTime()
+  const unsigned int widths[] = { 0, 7, 9, 12, 64 };
+  size_t code = 0;
+  uint64_t bit = 1;
+  while (code < 4 && bit == 1)
+  {
+    if (!bits.read(1, bit))
+    {
+      return false;
+    }
+    if (bit == 1)
+    {
+      ++code;
+    }
+  }
+  uint64_t dod = 0;
+  if (widths[code] > 0 && !bits.read(widths[code], dod))
+  {
+    return false;
+  }
+
+  previousDelta_ += unzigzag(dod);
+  previousTime_ += previousDelta_;
+  time = previousTime_;
+  return true;
+}
+
+bool SensorStreamReader::decodeValue(BitReader& bits, XorState& state, double& value)
+{
+  uint64_t control = 0;
+  if (!bits.read(1, control))
+  {
+    return false;
+  }
+  uint64_t x = 0;
+  if (control == 1)
+  {
+    if (!bits.read(1, control))
+    {
+      return false;
+    }
+    if (control == 1)
+    {
+      uint64_t leading = 0, meaningful = 0;
+      if (!bits.read(5, leading) || !bits.read(6, meaningful))
+      {
+        return false;
+      }
+      if (leading + meaningful + 1 > 64)
+      {
+        return false;
+      }
+      state.leading = leading;
+      state.trailing = 64 - leading - (meaningful + 1);
+    }
+    else if (state.leading + state.trailing >= 64)
+    {
+      // A reused window before any was set
+      return false;
+    }
+    if (!bits.read(64 - state.leading - state.trailing, x))
+    {
+      return false;
+    }
+    x <<= state.trailing;
+  }
+
+  state.previous ^= x;
+  std::memcpy(&value, &state.previous, sizeof(value));
+  return true;
+}
+}
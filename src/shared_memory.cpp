@@ -0,0 +1,143 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <ctime>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <ros/ros.h>
+
+#include <pal_hardware_gazebo/shared_memory.h>
+
+namespace gazebo_ros_control
+{
+SharedMemorySegment::SharedMemorySegment() : data_(NULL), size_(0)
+{
+}
+
+SharedMemorySegment::~SharedMemorySegment()
+{
+  destroy();
+}
+
+bool SharedMemorySegment::create(const std::string& name, size_t size)
+{
+  destroy();
+
+  // A segment left over by a crashed simulation may have another layout
+  shm_unlink(name.c_str());
+  const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+  if (fd < 0)
+  {
+    ROS_ERROR_STREAM("Could not create shared memory " << name << ": " << std::strerror(errno));
+    return false;
+  }
+  if (ftruncate(fd, size) != 0)
+  {
+    ROS_ERROR_STREAM("Could not size shared memory " << name << ": " << std::strerror(errno));
+    close(fd);
+    shm_unlink(name.c_str());
+    return false;
+  }
+  void* data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+  {
+    ROS_ERROR_STREAM("Could not map shared memory " << name << ": " << std::strerror(errno));
+    shm_unlink(name.c_str());
+    return false;
+  }
+
+  // Keep the pages resident, the mailbox is touched on every tick
+  mlock(data, size);
+  std::memset(data, 0, size);
+  name_ = name;
+  data_ = data;
+  size_ = size;
+  return true;
+}
+
+void SharedMemorySegment::destroy()
+{
+  if (!data_)
+  {
+    return;
+  }
+  munmap(data_, size_);
+  shm_unlink(name_.c_str());
+  data_ = NULL;
+  size_ = 0;
+}
+
+size_t packedNamesSize(const std::vector<std::string>& names)
+{
+  size_t size = 0;
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    size += names[i].size() + 1;
+  }
+  return size;
+}
+
+char* packNames(const std::vector<std::string>& names, char* out)
+{
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    std::memcpy(out, names[i].c_str(), names[i].size() + 1);
+    out += names[i].size() + 1;
+  }
+  return out;
+}
+
+bool futexWaitWhile(FutexWord& word, uint32_t value, double timeout)
+{
+  timespec now, deadline;
+  clock_gettime(CLOCK_MONOTONIC, &deadline);
+  deadline.tv_sec += static_cast<time_t>(timeout);
+  deadline.tv_nsec += static_cast<long>((timeout - static_cast<time_t>(timeout)) * 1e9);
+  if (deadline.tv_nsec >= 1000000000L)
+  {
+    ++deadline.tv_sec;
+    deadline.tv_nsec -= 1000000000L;
+  }
+
+  while (word.load(std::memory_order_acquire) == value)
+  {
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    timespec remaining;
+    remaining.tv_sec = deadline.tv_sec - now.tv_sec;
+    remaining.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+    if (remaining.tv_nsec < 0)
+    {
+      --remaining.tv_sec;
+      remaining.tv_nsec += 1000000000L;
+    }
+    if (remaining.tv_sec < 0)
+    {
+      return false;
+    }
+    // Not a private futex, the word lives in memory shared with another process
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, value, &remaining, NULL, 0);
+  }
+  return true;
+}
+
+void futexWake(FutexWord& word)
+{
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+}
@@ -0,0 +1,187 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <cmath>
+
+#include <pal_hardware_gazebo/wheel_odometry.h>
+
+namespace gazebo_ros_control
+{
+namespace
+{
+bool getCovarianceDiagonal(ros::NodeHandle& nh, const std::string& name, double* covariance)
+{
+  std::vector<double> diagonal(6, 0.);
+  nh.getParam(name, diagonal);
+  if (diagonal.size() != 6)
+  {
+    ROS_ERROR_STREAM("mobile_base/odometry/" << name << " must have 6 elements");
+    return false;
+  }
+  for (size_t i = 0; i < 6; ++i)
+  {
+    covariance[i * 7] = diagonal[i];
+  }
+  return true;
+}
+}
+
+WheelOdometry::WheelOdometry()
+  : enabled_(false)
+  , geometry_(NULL)
+  , joints_(NULL)
+  , x_(0.)
+  , y_(0.)
+  , yaw_(0.)
+  , linear_(0.)
+  , angular_(0.)
+  , publishDivider_(0)
+  , publishFactor_(1)
+  , ticks_(0)
+{
+}
+
+bool WheelOdometry::init(ros::NodeHandle& nh, const DiffDriveGeometry& geometry,
+                         const JointBuffers& joints)
+{
+  ros::NodeHandle odom_nh(nh, "mobile_base/odometry");
+  odom_nh.param("enabled", enabled_, false);
+  if (!enabled_)
+  {
+    return true;
+  }
+
+  geometry_ = &geometry;
+  joints_ = &joints;
+  odom_nh.param<std::string>("frame_id", frameId_, "odom");
+  odom_nh.param<std::string>("child_frame_id", childFrameId_, "base_footprint");
+  odom_nh.param("publish_divider", publishDivider_, 10);
+  if (publishDivider_ < 0)
+  {
+    ROS_ERROR_STREAM("mobile_base/odometry/publish_divider can not be negative");
+    return false;
+  }
+
+  bool enable_odom_tf;
+  odom_nh.param("enable_odom_tf", enable_odom_tf, true);
+
+  if (publishDivider_ > 0)
+  {
+    publisher_.reset(new realtime_tools::RealtimePublisher<nav_msgs::Odometry>(nh, "odom", 10));
+    nav_msgs::Odometry& msg = publisher_->msg_;
+    msg.header.frame_id = frameId_;
+    msg.child_frame_id = childFrameId_;
+    for (size_t i = 0; i < 36; ++i)
+    {
+      msg.pose.covariance[i] = 0.;
+      msg.twist.covariance[i] = 0.;
+    }
+    if (!getCovarianceDiagonal(odom_nh, "pose_covariance_diagonal", &msg.pose.covariance[0]) ||
+        !getCovarianceDiagonal(odom_nh, "twist_covariance_diagonal", &msg.twist.covariance[0]))
+    {
+      return false;
+    }
+    msg.pose.pose.position.z = 0.;
+    msg.pose.pose.orientation.x = 0.;
+    msg.pose.pose.orientation.y = 0.;
+    msg.twist.twist.linear.y = 0.;
+    msg.twist.twist.linear.z = 0.;
+    msg.twist.twist.angular.x = 0.;
+    msg.twist.twist.angular.y = 0.;
+  }
+
+  if (publishDivider_ > 0 && enable_odom_tf)
+  {
+    tfPublisher_.reset(
+        new realtime_tools::RealtimePublisher<tf2_msgs::TFMessage>(nh, "/tf", 100));
+    tfPublisher_->msg_.transforms.resize(1);
+    tfPublisher_->msg_.transforms[0].header.frame_id = frameId_;
+    tfPublisher_->msg_.transforms[0].child_frame_id = childFrameId_;
+    tfPublisher_->msg_.transforms[0].transform.translation.z = 0.;
+    tfPublisher_->msg_.transforms[0].transform.rotation.x = 0.;
+    tfPublisher_->msg_.transforms[0].transform.rotation.y = 0.;
+  }
+  return true;
+}
+
+void WheelOdometry::update(const ros::Time& time, const ros::Duration& period)
+{
+  geometry_->twist(DiffDriveGeometry::mean(geometry_->leftWheels, joints_->velocity),
+                   DiffDriveGeometry::mean(geometry_->rightWheels, joints_->velocity), linear_,
+                   angular_);
+
+  // Integrate along the arc, with the midpoint heading for straight motion
+  const double dt = period.toSec();
+  const double dyaw = angular_ * dt;
+  if (std::fabs(dyaw) < 1e-6)
+  {
+    const double heading = yaw_ + 0.5 * dyaw;
+    x_ += linear_ * dt * std::cos(heading);
+    y_ += linear_ * dt * std::sin(heading);
+  }
+  else
+  {
+    const double radius = linear_ / angular_;
+    x_ += radius * (std::sin(yaw_ + dyaw) - std::sin(yaw_));
+    y_ -= radius * (std::cos(yaw_ + dyaw) - std::cos(yaw_));
+  }
+  yaw_ = std::atan2(std::sin(yaw_ + dyaw), std::cos(yaw_ + dyaw));
+
+  if (publisher_ && ++ticks_ >= publishDivider_ * publishFactor_)
+  {
+    ticks_ = 0;
+    publish(time);
+  }
+}
+
+void WheelOdometry::publish(const ros::Time& time)
+{
+  const double qz = std::sin(0.5 * yaw_);
+  const double qw = std::cos(0.5 * yaw_);
+
+  // Each message is skipped if the previous one is still being sent
+  if (publisher_->trylock())
+  {
+    nav_msgs::Odometry& msg = publisher_->msg_;
+    msg.header.stamp = time;
+    msg.pose.pose.position.x = x_;
+    msg.pose.pose.position.y = y_;
+    msg.pose.pose.orientation.z = qz;
+    msg.pose.pose.orientation.w = qw;
+    msg.twist.twist.linear.x = linear_;
+    msg.twist.twist.angular.z = angular_;
+    publisher_->unlockAndPublish();
+  }
+
+  if (tfPublisher_ && tfPublisher_->trylock())
+  {
+    tf2_msgs::TFMessage& msg = tfPublisher_->msg_;
+    msg.transforms[0].header.stamp = time;
+    msg.transforms[0].transform.translation.x = x_;
+    msg.transforms[0].transform.translation.y = y_;
+    msg.transforms[0].transform.rotation.z = qz;
+    msg.transforms[0].transform.rotation.w = qw;
+    tfPublisher_->unlockAndPublish();
+  }
+}
+
+OdometryHandle::Data WheelOdometry::getHandleData(const std::string& name) const
+{
+  OdometryHandle::Data data;
+  data.name = name;
+  data.frame_id = frameId_;
+  data.child_frame_id = childFrameId_;
+  data.x = &x_;
+  data.y = &y_;
+  data.yaw = &yaw_;
+  data.linear = &linear_;
+  data.angular = &angular_;
+  return data;
+}
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <pal_hardware_gazebo/worker_pool.h>
+
+namespace gazebo_ros_control
+{
+WorkerPool::WorkerPool(size_t threads)
+  : generation_(0), stop_(false), busy_(0), task_(NULL), count_(0), next_(0), finished_(0)
+{
+  for (size_t i = 0; i < threads; ++i)
+  {
+    threads_.push_back(group_.create_thread(boost::bind(&WorkerPool::work, this)));
+  }
+}
+
+WorkerPool::~WorkerPool()
+{
+  {
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  group_.join_all();
+}
+
+void WorkerPool::run(size_t count, const Task& task)
+{
+  if (count == 0)
+  {
+    return;
+  }
+  if (threads_.empty() || count == 1)
+  {
+    for (size_t i = 0; i < count; ++i)
+    {
+      task(i);
+    }
+    return;
+  }
+
+  {
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    task_ = &task;
+    count_ = count;
+    next_ = 0;
+    finished_ = 0;
+    ++generation_;
+  }
+  wake_.notify_all();
+
+  drain();
+
+  // Workers still inside the batch could otherwise claim items of the next one
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  while (finished_ < count_ || busy_ > 0)
+  {
+    done_.wait(lock);
+  }
+  task_ = NULL;
+}
+
+void WorkerPool::drain()
+{
+  for (size_t i = next_++; i < count_; i = next_++)
+  {
+    (*task_)(i);
+    if (++finished_ == count_)
+    {
+      boost::unique_lock<boost::mutex> lock(mutex_);
+      done_.notify_all();
+    }
+  }
+}
+
+void WorkerPool::work()
+{
+  unsigned long seen = 0;
+  while (true)
+  {
+    {
+      boost::unique_lock<boost::mutex> lock(mutex_);
+      while (!stop_ && (generation_ == seen || !task_))
+      {
+        wake_.wait(lock);
+      }
+      if (stop_)
+      {
+        return;
+      }
+      seen = generation_;
+      ++busy_;
+    }
+    drain();
+    {
+      boost::unique_lock<boost::mutex> lock(mutex_);
+      if (--busy_ == 0)
+      {
+        done_.notify_all();
+      }
+    }
+  }
+}
+}
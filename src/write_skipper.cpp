@@ -0,0 +1,210 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <cmath>
+#include <cstring>
+
+#include <boost/bind.hpp>
+
+#include <pal_hardware_gazebo/write_skipper.h>
+
+namespace gazebo_ros_control
+{
+WriteSkipper::WriteSkipper()
+  : enabled_(false)
+  , positionDeadband_(1e-4)
+  , velocityDeadband_(1e-3)
+  , maxSkippedTicks_(100)
+  , joints_(NULL)
+  , skippedWrites_(0)
+{
+}
+
+bool WriteSkipper::init(ros::NodeHandle& nh, const JointBuffers& joints)
+{
+  ros::NodeHandle skip_nh(nh, "write_skipping");
+  skip_nh.param("enabled", enabled_, false);
+  if (!enabled_)
+  {
+    return true;
+  }
+
+  int max_skipped_ticks;
+  skip_nh.param("position_deadband", positionDeadband_, 1e-4);
+  skip_nh.param("velocity_deadband", velocityDeadband_, 1e-3);
+  skip_nh.param("max_skipped_ticks", max_skipped_ticks, 100);
+  if (positionDeadband_ < 0. || velocityDeadband_ < 0. || max_skipped_ticks < 0)
+  {
+    ROS_ERROR_STREAM("Write skipping deadbands and tick count can not be negative");
+    enabled_ = false;
+    return false;
+  }
+  maxSkippedTicks_ = max_skipped_ticks;
+
+  std::string gains_namespace;
+  skip_nh.param("gains_namespace", gains_namespace, std::string("gazebo_ros_control/pid_gains"));
+
+  joints_ = &joints;
+  JointCache empty = { false, 0., 0., false, { 0., 0., 0., 0., 0. }, { 0., 0., 0., 0. }, 0 };
+  cache_.assign(joints.size(), empty);
+  gains_.assign(joints.size(), boost::shared_ptr<GainsBuffer>());
+  gainsSubscribers_.clear();
+  for (size_t i = 0; i < joints.size(); ++i)
+  {
+    // Resources without gains set position and velocity commands kinematically
+    ros::NodeHandle gains_nh(nh, gains_namespace + "/" + joints.names[i]);
+    if (!joints.simJoints[i] || !gains_nh.hasParam("p"))
+    {
+      continue;
+    }
+    Gains gains = { 0., 0., 0., 0., 0. };
+    double i_clamp = 0.;
+    gains_nh.param("p", gains.p, 0.);
+    gains_nh.param("i", gains.i, 0.);
+    gains_nh.param("d", gains.d, 0.);
+    gains_nh.param("i_clamp", i_clamp, 0.);
+    gains_nh.param("i_clamp_min", gains.iMin, -std::fabs(i_clamp));
+    gains_nh.param("i_clamp_max", gains.iMax, std::fabs(i_clamp));
+    gains_[i].reset(new GainsBuffer(gains));
+    gainsSubscribers_.push_back(gains_nh.subscribe<dynamic_reconfigure::Config>(
+        "parameter_updates", 1, boost::bind(&WriteSkipper::gainsUpdated, this, _1, i)));
+  }
+  return true;
+}
+
+void WriteSkipper::gainsUpdated(const dynamic_reconfigure::ConfigConstPtr& config, size_t joint)
+{
+  Gains gains = *gains_[joint]->readFromNonRT();
+  for (size_t i = 0; i < config->doubles.size(); ++i)
+  {
+    const std::string& name = config->doubles[i].name;
+    const double value = config->doubles[i].value;
+    if (name == "p")
+    {
+      gains.p = value;
+    }
+    else if (name == "i")
+    {
+      gains.i = value;
+    }
+    else if (name == "d")
+    {
+      gains.d = value;
+    }
+    else if (name == "i_clamp_min")
+    {
+      gains.iMin = value;
+    }
+    else if (name == "i_clamp_max")
+    {
+      gains.iMax = value;
+    }
+  }
+  gains_[joint]->writeFromNonRT(gains);
+}
+
+WriteSkipper::Limits WriteSkipper::limits(size_t joint) const
+{
+  const gazebo::physics::JointPtr& sim_joint = joints_->simJoints[joint];
+#if GAZEBO_MAJOR_VERSION >= 8
+  const Limits limits = { sim_joint->LowerLimit(0), sim_joint->UpperLimit(0),
+                          sim_joint->GetVelocityLimit(0), sim_joint->GetEffortLimit(0) };
+#else
+  const Limits limits = { sim_joint->GetLowerLimit(0).Radian(),
+                          sim_joint->GetUpperLimit(0).Radian(), sim_joint->GetVelocityLimit(0),
+                          sim_joint->GetEffortLimit(0) };
+#endif
+  return limits;
+}
+
+void WriteSkipper::setActiveResources(const std::vector<std::string>& names,
+                                      const std::vector<JointBuffers::CommandType>& control_methods)
+{
+  activeJoints_.resize(names.size());
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    // Compare the command of the interface in use, not the first one the joint exposes
+    const int joint = joints_->index(names[i]);
+    const JointBuffers::CommandType method =
+        joint >= 0 ? control_methods[joint] : JointBuffers::NO_COMMAND;
+    const double* command = joint >= 0 ? joints_->commandFor(joint, method) : NULL;
+    const bool held = command && gains_[joint] &&
+                      (method == JointBuffers::POSITION_COMMAND ||
+                       method == JointBuffers::VELOCITY_COMMAND);
+    activeJoints_[i].joint = held ? joint : -1;
+    activeJoints_[i].controlMethod = method;
+    activeJoints_[i].command = command;
+    if (joint >= 0)
+    {
+      // Resources may have been reset by the switch, force a full write
+      cache_[joint].valid = false;
+    }
+  }
+}
+
+bool WriteSkipper::skip(size_t active_index, bool e_stop_active)
+{
+  if (active_index >= activeJoints_.size() || activeJoints_[active_index].joint < 0)
+  {
+    return false;
+  }
+  const ActiveJoint& active = activeJoints_[active_index];
+  const int joint = active.joint;
+  JointCache& cache = cache_[joint];
+  const double command = *active.command;
+  if (!cache.valid || cache.eStop != e_stop_active || cache.skippedTicks >= maxSkippedTicks_ ||
+      std::memcmp(&command, &cache.command, sizeof(command)) != 0)
+  {
+    return false;
+  }
+  const Gains& gains = *gains_[joint]->readFromRT();
+  const Limits current_limits = limits(joint);
+  if (std::memcmp(&gains, &cache.gains, sizeof(gains)) != 0 ||
+      std::memcmp(&current_limits, &cache.limits, sizeof(current_limits)) != 0)
+  {
+    return false;
+  }
+
+  const double velocity = *joints_->velocity[joint];
+  if (active.controlMethod == JointBuffers::POSITION_COMMAND)
+  {
+    if (std::fabs(command - *joints_->position[joint]) > positionDeadband_ ||
+        std::fabs(velocity) > velocityDeadband_)
+    {
+      return false;
+    }
+  }
+  else if (std::fabs(command - velocity) > velocityDeadband_)
+  {
+    return false;
+  }
+
+  joints_->simJoints[joint]->SetForce(0, cache.effort);
+  ++cache.skippedTicks;
+  ++skippedWrites_;
+  return true;
+}
+
+void WriteSkipper::written(size_t active_index, bool e_stop_active)
+{
+  if (active_index >= activeJoints_.size() || activeJoints_[active_index].joint < 0)
+  {
+    return;
+  }
+  const ActiveJoint& active = activeJoints_[active_index];
+  JointCache& cache = cache_[active.joint];
+  cache.valid = true;
+  cache.command = *active.command;
+  cache.effort = joints_->simJoints[active.joint]->GetForce(0);
+  cache.eStop = e_stop_active;
+  cache.gains = *gains_[active.joint]->readFromRT();
+  cache.limits = limits(active.joint);
+  cache.skippedTicks = 0;
+}
+}
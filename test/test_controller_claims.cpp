@@ -0,0 +1,263 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <hardware_interface/joint_command_interface.h>
+#include <hardware_interface/joint_state_interface.h>
+#include <hardware_interface/robot_hw.h>
+
+#include <pal_hardware_gazebo/controller_claims.h>
+
+using namespace gazebo_ros_control;
+
+namespace
+{
+/// More joints than a bitset word, so that claims span two of them
+const size_t JOINTS = 70;
+
+std::string jointName(size_t i)
+{
+  std::ostringstream name;
+  name << "joint_" << i;
+  return name.str();
+}
+
+/// Position controlled joints, without a simulation behind them
+class TestRobot : public hardware_interface::RobotHW
+{
+public:
+  TestRobot() : position_(JOINTS), velocity_(JOINTS), effort_(JOINTS), command_(JOINTS)
+  {
+    for (size_t i = 0; i < JOINTS; ++i)
+    {
+      hardware_interface::JointStateHandle state(jointName(i), &position_[i], &velocity_[i],
+                                                 &effort_[i]);
+      jointState_.registerHandle(state);
+      positionCommand_.registerHandle(hardware_interface::JointHandle(state, &command_[i]));
+    }
+    registerInterface(&jointState_);
+    registerInterface(&positionCommand_);
+  }
+
+  hardware_interface::JointStateInterface jointState_;
+  hardware_interface::PositionJointInterface positionCommand_;
+  std::vector<double> position_, velocity_, effort_, command_;
+};
+
+const ControllerClaims::ControllerList NONE;
+
+class ControllerClaimsTest : public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    ASSERT_TRUE(joints_.init(&robot_, gazebo::physics::ModelPtr()));
+    ASSERT_EQ(JOINTS, joints_.size());
+    claims_.init(joints_);
+  }
+
+  static hardware_interface::ControllerInfo controller(const std::string& name,
+                                                       const std::vector<std::string>& resources)
+  {
+    hardware_interface::ControllerInfo info;
+    info.name = name;
+    info.type = "position_controllers/JointGroupPositionController";
+    hardware_interface::InterfaceResources claimed;
+    claimed.hardware_interface = "hardware_interface::PositionJointInterface";
+    claimed.resources.insert(resources.begin(), resources.end());
+    info.claimed_resources.push_back(claimed);
+    return info;
+  }
+
+  static hardware_interface::ControllerInfo controller(const std::string& name,
+                                                       const std::string& resource)
+  {
+    return controller(name, std::vector<std::string>(1, resource));
+  }
+
+  static ControllerClaims::ControllerList list(const hardware_interface::ControllerInfo& info)
+  {
+    return ControllerClaims::ControllerList(1, info);
+  }
+
+  bool active(const std::string& joint) const
+  {
+    return claims_.active().test(joints_.index(joint));
+  }
+
+  /// Starts the controllers through the same calls as a controller switch
+  void start(const ControllerClaims::ControllerList& start_list,
+             const ControllerClaims::ControllerList& stop_list = NONE)
+  {
+    std::string resource;
+    ASSERT_FALSE(claims_.findSwitchConflict(start_list, stop_list, resource)) << resource;
+    claims_.doSwitch(start_list, stop_list);
+  }
+
+  TestRobot robot_;
+  JointBuffers joints_;
+  ControllerClaims claims_;
+};
+}
+
+TEST(ResourceBitsetTest, SpansSeveralWords)
+{
+  ResourceBitset a(JOINTS);
+  ResourceBitset b(JOINTS);
+  EXPECT_FALSE(a.any());
+  a.set(3);
+  a.set(65);
+  b.set(65);
+  b.set(69);
+  EXPECT_TRUE(a.test(65));
+  EXPECT_FALSE(a.test(64));
+  EXPECT_TRUE(a.intersects(b));
+  EXPECT_EQ(65u, a.firstCommon(b));
+  b.reset(65);
+  EXPECT_FALSE(a.intersects(b));
+  EXPECT_EQ(JOINTS, a.firstCommon(b));
+
+  a |= b;
+  EXPECT_TRUE(a.test(69));
+  a.subtract(b);
+  EXPECT_TRUE(a.test(3));
+  EXPECT_TRUE(a.test(65));
+  EXPECT_FALSE(a.test(69));
+  a.clear();
+  EXPECT_FALSE(a.any());
+}
+
+TEST_F(ControllerClaimsTest, DetectsSharedJoints)
+{
+  std::vector<std::string> arm;
+  arm.push_back("joint_1");
+  arm.push_back("joint_66");
+  std::vector<std::string> wrist;
+  wrist.push_back("joint_2");
+  wrist.push_back("joint_66");
+
+  ControllerClaims::ControllerList controllers;
+  controllers.push_back(controller("arm_controller", arm));
+  controllers.push_back(controller("head_controller", "joint_3"));
+  std::string resource;
+  EXPECT_FALSE(claims_.findConflict(controllers, resource));
+
+  controllers.push_back(controller("wrist_controller", wrist));
+  ASSERT_TRUE(claims_.findConflict(controllers, resource));
+  EXPECT_EQ("joint_66", resource);
+}
+
+TEST_F(ControllerClaimsTest, DetectsSharedResourcesThatAreNotJoints)
+{
+  ControllerClaims::ControllerList controllers;
+  controllers.push_back(controller("base_controller", "base_wheels"));
+  controllers.push_back(controller("odometry_controller", "base_wheels"));
+  std::string resource;
+  ASSERT_TRUE(claims_.findConflict(controllers, resource));
+  EXPECT_EQ("base_wheels", resource);
+}
+
+TEST_F(ControllerClaimsTest, SwitchConflictsWithRunningControllers)
+{
+  const hardware_interface::ControllerInfo arm = controller("arm_controller", "joint_1");
+  const hardware_interface::ControllerInfo other = controller("other_controller", "joint_1");
+  start(list(arm));
+  EXPECT_TRUE(active("joint_1"));
+
+  std::string resource;
+  ASSERT_TRUE(claims_.findSwitchConflict(list(other), NONE, resource));
+  EXPECT_EQ("joint_1", resource);
+
+  // Stopping the running controller in the same switch frees its joints
+  start(list(other), list(arm));
+  EXPECT_TRUE(active("joint_1"));
+  claims_.doSwitch(NONE, list(other));
+  EXPECT_FALSE(claims_.active().any());
+}
+
+TEST_F(ControllerClaimsTest, ExpandsGroups)
+{
+  std::vector<size_t> arm_joints;
+  arm_joints.push_back(joints_.index("joint_4"));
+  arm_joints.push_back(joints_.index("joint_5"));
+  arm_joints.push_back(joints_.index("joint_67"));
+  EXPECT_EQ(0u, claims_.addGroup("arm", arm_joints));
+  EXPECT_EQ(0, claims_.groupIndex().find("arm"));
+
+  ControllerClaims::ControllerList controllers;
+  controllers.push_back(controller("arm_controller", "arm"));
+  controllers.push_back(controller("elbow_controller", "joint_67"));
+  std::string resource;
+  ASSERT_TRUE(claims_.findConflict(controllers, resource));
+  EXPECT_EQ("joint_67", resource);
+
+  start(list(controller("arm_controller", "arm")));
+  EXPECT_TRUE(claims_.activeGroups().test(0));
+  for (size_t i = 0; i < JOINTS; ++i)
+  {
+    EXPECT_EQ(i == 4 || i == 5 || i == 67, active(jointName(i))) << jointName(i);
+  }
+
+  claims_.doSwitch(NONE, list(controller("arm_controller", "arm")));
+  EXPECT_FALSE(claims_.activeGroups().test(0));
+  EXPECT_FALSE(claims_.active().any());
+}
+
+TEST_F(ControllerClaimsTest, ReloadedControllerClaimsItsNewJoints)
+{
+  start(list(controller("arm_controller", "joint_1")));
+  claims_.doSwitch(NONE, list(controller("arm_controller", "joint_1")));
+
+  // Unloaded and loaded again under the same name with other joints
+  start(list(controller("arm_controller", "joint_68")));
+  EXPECT_FALSE(active("joint_1"));
+  EXPECT_TRUE(active("joint_68"));
+
+  std::string resource;
+  EXPECT_FALSE(
+      claims_.findSwitchConflict(list(controller("other_controller", "joint_1")), NONE, resource));
+  ASSERT_TRUE(
+      claims_.findSwitchConflict(list(controller("other_controller", "joint_68")), NONE, resource));
+  EXPECT_EQ("joint_68", resource);
+}
+
+TEST_F(ControllerClaimsTest, LoadedControllerClaimsAreNotCached)
+{
+  // Checked on load, then loaded again with other joints before ever starting
+  std::string resource;
+  EXPECT_FALSE(claims_.findConflict(list(controller("arm_controller", "joint_1")), resource));
+  start(list(controller("arm_controller", "joint_2")));
+  EXPECT_FALSE(active("joint_1"));
+  EXPECT_TRUE(active("joint_2"));
+}
+
+TEST_F(ControllerClaimsTest, ReservedJointsConflictWithEveryController)
+{
+  claims_.reserve(controller("pal_hardware_gazebo/policy", "joint_69"));
+  EXPECT_TRUE(claims_.reserved().test(joints_.index("joint_69")));
+  EXPECT_FALSE(active("joint_69"));
+
+  std::string resource;
+  ASSERT_TRUE(claims_.findConflict(list(controller("arm_controller", "joint_69")), resource));
+  EXPECT_EQ("joint_69", resource);
+  ASSERT_TRUE(
+      claims_.findSwitchConflict(list(controller("arm_controller", "joint_69")), NONE, resource));
+  EXPECT_EQ("joint_69", resource);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
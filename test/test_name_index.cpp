@@ -0,0 +1,102 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <pal_hardware_gazebo/name_index.h>
+
+using namespace gazebo_ros_control;
+
+namespace
+{
+/// Names shaped like the joints of a robot, sharing long prefixes
+std::vector<std::string> jointNames(size_t count)
+{
+  std::vector<std::string> names;
+  for (size_t i = 0; i < count; ++i)
+  {
+    std::ostringstream name;
+    name << (i % 2 ? "arm_left_" : "arm_right_") << i / 2 + 1 << "_joint";
+    names.push_back(name.str());
+  }
+  return names;
+}
+}
+
+TEST(NameIndexTest, FindsEveryBuiltName)
+{
+  const size_t counts[] = { 1, 2, 3, 7, 64, 65, 300 };
+  for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+  {
+    const std::vector<std::string> names = jointNames(counts[c]);
+    NameIndex index;
+    ASSERT_TRUE(index.build(names));
+    ASSERT_EQ(names.size(), index.size());
+    EXPECT_EQ(names, index.names());
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+      EXPECT_EQ(static_cast<int>(i), index.find(names[i])) << names[i];
+    }
+  }
+}
+
+TEST(NameIndexTest, RejectsUnknownNames)
+{
+  const std::vector<std::string> names = jointNames(40);
+  NameIndex index;
+  ASSERT_TRUE(index.build(names));
+  EXPECT_EQ(-1, index.find(""));
+  EXPECT_EQ(-1, index.find("arm_left_1"));
+  EXPECT_EQ(-1, index.find("arm_left_1_joint "));
+  EXPECT_EQ(-1, index.find("arm_left_21_joint"));
+  // Every slot is probed by some unknown name, none may match
+  const std::vector<std::string> others = jointNames(400);
+  for (size_t i = names.size(); i < others.size(); ++i)
+  {
+    EXPECT_EQ(-1, index.find(others[i])) << others[i];
+  }
+}
+
+TEST(NameIndexTest, RejectsDuplicates)
+{
+  std::vector<std::string> names = jointNames(10);
+  names.push_back(names[3]);
+  NameIndex index;
+  EXPECT_FALSE(index.build(names));
+}
+
+TEST(NameIndexTest, EmptyInput)
+{
+  NameIndex index;
+  EXPECT_EQ(-1, index.find("arm_left_1_joint"));
+  ASSERT_TRUE(index.build(std::vector<std::string>()));
+  EXPECT_EQ(0u, index.size());
+  EXPECT_EQ(-1, index.find(""));
+  EXPECT_EQ(-1, index.find("arm_left_1_joint"));
+}
+
+TEST(NameIndexTest, RebuildForgetsPreviousNames)
+{
+  NameIndex index;
+  ASSERT_TRUE(index.build(jointNames(20)));
+  const std::vector<std::string> names(1, "torso_lift_joint");
+  ASSERT_TRUE(index.build(names));
+  EXPECT_EQ(0, index.find("torso_lift_joint"));
+  EXPECT_EQ(-1, index.find("arm_left_1_joint"));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,251 @@
+/*
+ * Copyright 2019 PAL Robotics SL. All Rights Reserved
+ *
+ * Unauthorized copying of this file, via any medium is strictly prohibited,
+ * unless it was supplied under the terms of a license agreement or
+ * nondisclosure agreement with PAL Robotics SL. In this case it may not be
+ * copied or disclosed except in accordance with the terms of that agreement.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <pal_hardware_gazebo/columnar_exporter.h>
+#include <pal_hardware_gazebo/sensor_stream_recorder.h>
+
+using namespace gazebo_ros_control;
+
+namespace
+{
+const size_t SIGNALS = 5;
+const size_t ROWS = 250;
+
+std::string tempFile(const std::string& name)
+{
+  std::ostringstream path;
+  path << P_tmpdir << "/pal_hardware_gazebo_" << getpid() << "_" << name;
+  return path.str();
+}
+
+/// Rows of time followed by signals that exercise every encoding branch
+std::vector<double> makeRows()
+{
+  std::vector<double> rows;
+  int64_t time_ns = 1000000000;
+  uint64_t random = 0x9e3779b97f4a7c15ull;
+  for (size_t r = 0; r < ROWS; ++r)
+  {
+    // Regular steps, with jitter and jumps of every size now and then
+    if (r % 17 == 0)
+    {
+      time_ns += 1000000 + 37;
+    }
+    else if (r % 29 == 0)
+    {
+      time_ns += 3000000000ll;
+    }
+    else if (r % 11 == 0)
+    {
+      time_ns += 1000000 + 300;
+    }
+    else
+    {
+      time_ns += 1000000;
+    }
+    rows.push_back(time_ns * 1e-9);
+
+    random ^= random << 13;
+    random ^= random >> 7;
+    random ^= random << 17;
+    double noise;
+    std::memcpy(&noise, &random, sizeof(noise));
+
+    rows.push_back(1.5);
+    rows.push_back(std::sin(0.01 * r));
+    rows.push_back(r % 3 == 0 ? 0. : -0.);
+    rows.push_back(r % 50 == 0 ? std::numeric_limits<double>::infinity() : 1e-300 * r);
+    rows.push_back(noise);
+  }
+  return rows;
+}
+
+/// Records the rows through the writer, one tick per row
+template <class Writer>
+void recordRows(Writer& writer, const std::vector<double>& rows)
+{
+  std::vector<double> values(SIGNALS);
+  for (size_t i = 0; i < SIGNALS; ++i)
+  {
+    std::ostringstream name;
+    name << "signal_" << i;
+    writer.addSignal(name.str(), &values[i]);
+  }
+  ASSERT_TRUE(writer.start());
+  for (size_t r = 0; r < ROWS; ++r)
+  {
+    const double* row = &rows[r * (SIGNALS + 1)];
+    std::copy(row + 1, row + SIGNALS + 1, values.begin());
+    const int64_t time_ns = llround(row[0] * 1e9);
+    writer.record(ros::Time(time_ns / 1000000000, time_ns % 1000000000));
+  }
+  writer.stop();
+}
+
+void expectNames(const std::vector<std::string>& names)
+{
+  ASSERT_EQ(SIGNALS + 1, names.size());
+  EXPECT_EQ("time", names[0]);
+  EXPECT_EQ("signal_0", names[1]);
+  EXPECT_EQ("signal_4", names[SIGNALS]);
+}
+
+void expectSameRows(const std::vector<double>& expected, const std::vector<double>& actual,
+                    double time_tolerance)
+{
+  ASSERT_EQ(expected.size(), actual.size());
+  for (size_t i = 0; i < expected.size(); ++i)
+  {
+    if (i % (SIGNALS + 1) == 0)
+    {
+      EXPECT_NEAR(expected[i], actual[i], time_tolerance) << "row " << i / (SIGNALS + 1);
+    }
+    else
+    {
+      // Bit exact, including signed zeros and infinities
+      EXPECT_EQ(0, std::memcmp(&expected[i], &actual[i], sizeof(double)))
+          << "row " << i / (SIGNALS + 1) << " signal " << i % (SIGNALS + 1) - 1;
+    }
+  }
+}
+
+void truncate(const std::string& file_name, long bytes)
+{
+  FILE* file = std::fopen(file_name.c_str(), "r+b");
+  ASSERT_TRUE(file != NULL);
+  std::fseek(file, 0, SEEK_END);
+  const long size = std::ftell(file);
+  std::fclose(file);
+  ASSERT_EQ(0, ::truncate(file_name.c_str(), size - bytes));
+}
+}
+
+TEST(SensorStreamTest, RoundTrip)
+{
+  const std::string file_name = tempFile("stream.palrec");
+  const std::vector<double> rows = makeRows();
+  {
+    SensorStreamRecorder recorder;
+    ASSERT_TRUE(recorder.configure(file_name, 64, 1000, 1));
+    recordRows(recorder, rows);
+  }
+
+  SensorStreamReader reader;
+  ASSERT_TRUE(reader.open(file_name));
+  expectNames(reader.names());
+  std::vector<double> read;
+  size_t blocks = 0;
+  while (reader.readBlock(read))
+  {
+    ++blocks;
+  }
+  EXPECT_EQ((ROWS + 63) / 64, blocks);
+  expectSameRows(rows, read, 1e-9);
+  std::remove(file_name.c_str());
+}
+
+TEST(SensorStreamTest, TruncatedFileKeepsCompleteBlocks)
+{
+  const std::string file_name = tempFile("truncated.palrec");
+  const std::vector<double> rows = makeRows();
+  {
+    SensorStreamRecorder recorder;
+    ASSERT_TRUE(recorder.configure(file_name, 100, 1000, 1));
+    recordRows(recorder, rows);
+  }
+  truncate(file_name, 10);
+
+  SensorStreamReader reader;
+  ASSERT_TRUE(reader.open(file_name));
+  std::vector<double> read;
+  while (reader.readBlock(read))
+  {
+  }
+  const std::vector<double> complete(rows.begin(), rows.begin() + 200 * (SIGNALS + 1));
+  expectSameRows(complete, read, 1e-9);
+  std::remove(file_name.c_str());
+}
+
+TEST(SensorStreamTest, RejectsOtherFormats)
+{
+  const std::string file_name = tempFile("columns.palcol");
+  {
+    ColumnarExporter exporter;
+    ASSERT_TRUE(exporter.configure(file_name, 10, 1000, 1));
+    recordRows(exporter, makeRows());
+  }
+  SensorStreamReader reader;
+  EXPECT_FALSE(reader.open(file_name));
+  std::remove(file_name.c_str());
+}
+
+TEST(ColumnarTest, RoundTrip)
+{
+  const std::string file_name = tempFile("columns.palcol");
+  const std::vector<double> rows = makeRows();
+  {
+    ColumnarExporter exporter;
+    ASSERT_TRUE(exporter.configure(file_name, 64, 1000, 1));
+    recordRows(exporter, rows);
+  }
+
+  ColumnarReader reader;
+  ASSERT_TRUE(reader.open(file_name));
+  expectNames(reader.names());
+  std::vector<double> read;
+  size_t chunks = 0;
+  while (reader.readChunk(read))
+  {
+    ++chunks;
+  }
+  EXPECT_EQ((ROWS + 63) / 64, chunks);
+  expectSameRows(rows, read, 1e-12);
+  std::remove(file_name.c_str());
+}
+
+TEST(ColumnarTest, TruncatedFileKeepsCompleteChunks)
+{
+  const std::string file_name = tempFile("truncated.palcol");
+  const std::vector<double> rows = makeRows();
+  {
+    ColumnarExporter exporter;
+    ASSERT_TRUE(exporter.configure(file_name, 100, 1000, 1));
+    recordRows(exporter, rows);
+  }
+  truncate(file_name, 10);
+
+  ColumnarReader reader;
+  ASSERT_TRUE(reader.open(file_name));
+  std::vector<double> read;
+  while (reader.readChunk(read))
+  {
+  }
+  const std::vector<double> complete(rows.begin(), rows.begin() + 200 * (SIGNALS + 1));
+  expectSameRows(complete, read, 1e-12);
+  std::remove(file_name.c_str());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}